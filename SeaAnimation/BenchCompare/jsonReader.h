@@ -0,0 +1,182 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdlib.h>
+
+// Just enough JSON to read the reports written by SceneBenchmark: objects, arrays, numbers, strings,
+// true, false and null, with no unicode escapes.
+struct JsonValue {
+	enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+	Type type;
+	double number;
+	std::string text;
+	std::vector<JsonValue> items;
+	std::vector<std::pair<std::string, JsonValue>> members;
+
+	JsonValue() :
+		type(NUL),
+		number(0.0)
+	{}
+
+	// member by name, a null value if there is none
+	const JsonValue& operator[](const std::string& name) const
+	{
+		static const JsonValue missing;
+		for (unsigned int i = 0; i < members.size(); i++)
+		{
+			if (members[i].first == name)
+				return members[i].second;
+		}
+		return missing;
+	}
+
+	// the numbers of an array
+	std::vector<double> numbers() const
+	{
+		std::vector<double> values;
+		for (unsigned int i = 0; i < items.size(); i++)
+		{
+			if (items[i].type == NUMBER)
+				values.push_back(items[i].number);
+		}
+		return values;
+	}
+};
+
+class JsonReader
+{
+public:
+	static bool readFile(const std::string& path, JsonValue& value)
+	{
+		std::ifstream file(path.c_str());
+		if (!file)
+		{
+			std::cout << "ERROR::JSON::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+			return false;
+		}
+		std::stringstream contents;
+		contents << file.rdbuf();
+		JsonReader reader(contents.str());
+		if (!reader.parseValue(value) || (reader.skipSpace(), reader.position != reader.source.size()))
+		{
+			std::cout << "ERROR::JSON::PARSE " << path << " at byte " << reader.position << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+private:
+	const std::string source;
+	size_t position;
+
+	JsonReader(const std::string& text) :
+		source(text),
+		position(0)
+	{}
+
+	void skipSpace()
+	{
+		while (position < source.size() && (source[position] == ' ' || source[position] == '\t' || source[position] == '\n' || source[position] == '\r'))
+			position++;
+	}
+
+	bool consume(char c)
+	{
+		skipSpace();
+		if (position < source.size() && source[position] == c)
+		{
+			position++;
+			return true;
+		}
+		return false;
+	}
+
+	bool parseValue(JsonValue& value)
+	{
+		skipSpace();
+		if (position >= source.size())
+			return false;
+		char c = source[position];
+		if (c == '{')
+			return parseObject(value);
+		if (c == '[')
+			return parseArray(value);
+		if (c == '"')
+		{
+			value.type = JsonValue::STRING;
+			return parseString(value.text);
+		}
+		if (source.compare(position, 4, "true") == 0 || source.compare(position, 5, "false") == 0)
+		{
+			value.type = JsonValue::BOOLEAN;
+			value.number = c == 't' ? 1.0 : 0.0;
+			position += c == 't' ? 4 : 5;
+			return true;
+		}
+		if (source.compare(position, 4, "null") == 0)
+		{
+			value.type = JsonValue::NUL;
+			position += 4;
+			return true;
+		}
+		const char* start = source.c_str() + position;
+		char* end = NULL;
+		value.number = strtod(start, &end);
+		if (end == start)
+			return false;
+		value.type = JsonValue::NUMBER;
+		position += end - start;
+		return true;
+	}
+
+	bool parseString(std::string& text)
+	{
+		if (!consume('"'))
+			return false;
+		text.clear();
+		while (position < source.size() && source[position] != '"')
+		{
+			if (source[position] == '\\' && position + 1 < source.size())
+				position++;
+			text += source[position++];
+		}
+		return consume('"');
+	}
+
+	bool parseArray(JsonValue& value)
+	{
+		value.type = JsonValue::ARRAY;
+		consume('[');
+		if (consume(']'))
+			return true;
+		do
+		{
+			value.items.push_back(JsonValue());
+			if (!parseValue(value.items.back()))
+				return false;
+		} while (consume(','));
+		return consume(']');
+	}
+
+	bool parseObject(JsonValue& value)
+	{
+		value.type = JsonValue::OBJECT;
+		consume('{');
+		if (consume('}'))
+			return true;
+		do
+		{
+			skipSpace();
+			value.members.push_back(std::make_pair(std::string(), JsonValue()));
+			if (!parseString(value.members.back().first) || !consume(':') || !parseValue(value.members.back().second))
+				return false;
+		} while (consume(','));
+		return consume('}');
+	}
+};
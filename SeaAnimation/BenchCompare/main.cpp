@@ -0,0 +1,204 @@
+#include "jsonReader.h"
+#include "mannWhitney.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace std;
+
+// Compares SeaAnimation --benchmark reports: the first one is the baseline, every other one is
+// compared against it segment by segment. Frame, stage and pass times are tested with Mann-Whitney on
+// the recorded samples; a change is reported when it is significant and larger than the thresholds.
+// The per-frame counters are the same every run of the same build and are only held against the
+// thresholds. Reports without stage and pass samples have their means shown, untested, and those
+// never fail the run.
+//
+// usage: BenchCompare baseline.json candidate.json [more.json...] [--alpha 0.01] [--threshold 2] [--min-ms 0.05] [--all]
+// exits with 1 when any candidate has a regression, so it can gate a change.
+
+struct Options {
+    double alpha = 0.01;        // significance level of the test
+    double thresholdPercent = 2.0; // smallest relative change worth reporting
+    double minMs = 0.05;        // smallest absolute change of a time worth reporting
+    bool all = false;           // print unchanged metrics too
+};
+
+struct Comparison {
+    string segment;
+    string metric;
+    double baseline;
+    double candidate;
+    double p;                   // -1 when there were no samples to test
+    int verdict;                // 1 regression, -1 improvement, 0 neither
+    bool gates;                 // a regression fails the run
+};
+
+static string segmentName(const JsonValue& segment)
+{
+    return "preset " + to_string((int)segment["preset"].number) + " " + segment["view"].text;
+}
+
+static int judge(double baseline, double candidate, bool isTime, bool tested, double p, const Options& options)
+{
+    double change = candidate - baseline;
+    if (tested && p >= options.alpha)
+        return 0;
+    if (fabs(change) < (baseline != 0.0 ? fabs(baseline) : 1.0) * options.thresholdPercent / 100.0)
+        return 0;
+    if (isTime && fabs(change) < options.minMs)
+        return 0;
+    // every metric in the report is better lower
+    return change > 0.0 ? 1 : -1;
+}
+
+static void compareSamples(const string& segment, const string& metric, const JsonValue& base, const JsonValue& cand,
+    const Options& options, vector<Comparison>& out)
+{
+    vector<double> a = base.numbers(), b = cand.numbers();
+    if (a.empty() || b.empty())
+        return;
+    Comparison c;
+    c.segment = segment;
+    c.metric = metric;
+    c.baseline = median(a);
+    c.candidate = median(b);
+    c.p = mannWhitney(a, b).p;
+    c.verdict = judge(c.baseline, c.candidate, true, true, c.p, options);
+    c.gates = true;
+    out.push_back(c);
+}
+
+// an object of sample arrays, as the report keeps the stage and pass times
+static void compareColumns(const string& segment, const string& group, const JsonValue& base, const JsonValue& cand,
+    const Options& options, vector<Comparison>& out)
+{
+    for (unsigned int i = 0; i < base.members.size(); i++)
+        compareSamples(segment, group + "." + base.members[i].first + " (median)", base.members[i].second, cand[base.members[i].first], options, out);
+}
+
+static void compareMeans(const string& segment, const string& group, const JsonValue& base, const JsonValue& cand, bool isTime,
+    bool gates, const Options& options, vector<Comparison>& out)
+{
+    for (unsigned int i = 0; i < base.members.size(); i++)
+    {
+        const JsonValue& other = cand[base.members[i].first];
+        if (other.type != JsonValue::NUMBER)
+            continue;
+        Comparison c;
+        c.segment = segment;
+        c.metric = group + "." + base.members[i].first;
+        c.baseline = base.members[i].second.number;
+        c.candidate = other.number;
+        c.p = -1.0;
+        c.verdict = judge(c.baseline, c.candidate, isTime, false, 1.0, options);
+        c.gates = gates;
+        out.push_back(c);
+    }
+}
+
+static void compareReports(const JsonValue& base, const JsonValue& cand, const Options& options, vector<Comparison>& out)
+{
+    const JsonValue& baseSegments = base["segments"];
+    const JsonValue& candSegments = cand["segments"];
+    for (unsigned int i = 0; i < baseSegments.items.size(); i++)
+    {
+        const JsonValue& b = baseSegments.items[i];
+        string name = segmentName(b);
+        const JsonValue* c = NULL;
+        for (unsigned int j = 0; j < candSegments.items.size(); j++)
+        {
+            if (segmentName(candSegments.items[j]) == name)
+                c = &candSegments.items[j];
+        }
+        if (!c)
+        {
+            cout << "  " << name << ": missing from the candidate" << endl;
+            continue;
+        }
+        compareSamples(name, "cpu frame ms (median)", b["cpu_ms_samples"], (*c)["cpu_ms_samples"], options, out);
+        compareSamples(name, "gpu frame ms (median)", b["gpu_ms_samples"], (*c)["gpu_ms_samples"], options, out);
+        // reports from before the stage and pass samples only have their means
+        if (b["cpu_stage_samples"].type == JsonValue::OBJECT && (*c)["cpu_stage_samples"].type == JsonValue::OBJECT)
+            compareColumns(name, "cpu stage ms", b["cpu_stage_samples"], (*c)["cpu_stage_samples"], options, out);
+        else
+            compareMeans(name, "cpu_stages_ms", b["cpu_stages_ms"], (*c)["cpu_stages_ms"], true, false, options, out);
+        if (b["gpu_pass_samples"].type == JsonValue::OBJECT && (*c)["gpu_pass_samples"].type == JsonValue::OBJECT)
+            compareColumns(name, "gpu pass ms", b["gpu_pass_samples"], (*c)["gpu_pass_samples"], options, out);
+        else
+            compareMeans(name, "gpu_passes_ms", b["gpu_passes_ms"], (*c)["gpu_passes_ms"], true, false, options, out);
+        compareMeans(name, "per_frame", b["per_frame"], (*c)["per_frame"], false, true, options, out);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    vector<string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--alpha" && i + 1 < argc)
+            options.alpha = atof(argv[++i]);
+        else if (arg == "--threshold" && i + 1 < argc)
+            options.thresholdPercent = atof(argv[++i]);
+        else if (arg == "--min-ms" && i + 1 < argc)
+            options.minMs = atof(argv[++i]);
+        else if (arg == "--all")
+            options.all = true;
+        else
+            paths.push_back(arg);
+    }
+    if (paths.size() < 2)
+    {
+        cout << "usage: BenchCompare baseline.json candidate.json [more.json...] [--alpha 0.01] [--threshold 2] [--min-ms 0.05] [--all]" << endl;
+        return 2;
+    }
+
+    JsonValue baseline;
+    if (!JsonReader::readFile(paths[0], baseline))
+        return 2;
+
+    unsigned int regressions = 0;
+    for (unsigned int r = 1; r < paths.size(); r++)
+    {
+        JsonValue candidate;
+        if (!JsonReader::readFile(paths[r], candidate))
+            return 2;
+        cout << paths[r] << " against " << paths[0] << " (alpha " << options.alpha << ", threshold "
+            << options.thresholdPercent << "%, " << options.minMs << " ms)" << endl;
+
+        vector<Comparison> comparisons;
+        compareReports(baseline, candidate, options, comparisons);
+        cout << left << setw(18) << "  segment" << setw(34) << "metric" << right << setw(12) << "baseline"
+            << setw(12) << "candidate" << setw(10) << "change" << setw(10) << "p" << "  verdict" << endl;
+        unsigned int shown = 0;
+        for (unsigned int i = 0; i < comparisons.size(); i++)
+        {
+            const Comparison& c = comparisons[i];
+            if (c.verdict == 0 && !options.all)
+                continue;
+            double change = c.baseline != 0.0 ? 100.0 * (c.candidate - c.baseline) / fabs(c.baseline) : 0.0;
+            // formatted on a stream of its own so cout keeps its flags for the next header
+            ostringstream row;
+            row << fixed << setprecision(3) << left << "  " << setw(16) << c.segment << setw(34) << c.metric << right
+                << setw(12) << c.baseline << setw(12) << c.candidate << setw(9) << setprecision(1) << showpos << change << "%" << noshowpos;
+            if (c.p >= 0.0)
+                row << setw(10) << scientific << setprecision(1) << c.p;
+            else
+                row << setw(10) << "-";
+            const char* verdict = c.verdict > 0 ? (c.gates ? "REGRESSION" : "slower, untested") : c.verdict < 0 ? "improvement" : "";
+            cout << row.str() << "  " << verdict << endl;
+            regressions += c.verdict > 0 && c.gates ? 1 : 0;
+            shown++;
+        }
+        if (shown == 0)
+            cout << "  no significant changes" << endl;
+        cout << endl;
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <math.h>
+
+struct MannWhitneyResult {
+	double u;      // U statistic of the first sample
+	double z;      // normal approximation, positive when the second sample tends to be larger
+	double p;      // two sided
+};
+
+// Mann-Whitney U test of whether one sample tends to have larger values than the other, with the
+// normal approximation (tie corrected, with continuity correction). Frame times are far from normal
+// and full of outliers, which is why it compares ranks rather than means. Needs a few dozen values in
+// each sample for the approximation to hold; the benchmark records hundreds.
+inline MannWhitneyResult mannWhitney(const std::vector<double>& a, const std::vector<double>& b)
+{
+	MannWhitneyResult result = { 0.0, 0.0, 1.0 };
+	size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+	if (n1 == 0 || n2 == 0)
+		return result;
+
+	// pooled values tagged with their sample, ranked with ties sharing their mean rank
+	std::vector<std::pair<double, int>> pooled;
+	pooled.reserve(n);
+	for (size_t i = 0; i < n1; i++)
+		pooled.push_back(std::make_pair(a[i], 0));
+	for (size_t i = 0; i < n2; i++)
+		pooled.push_back(std::make_pair(b[i], 1));
+	std::sort(pooled.begin(), pooled.end());
+
+	double rankSumA = 0.0;
+	double tieTerm = 0.0;
+	for (size_t i = 0; i < n;)
+	{
+		size_t j = i;
+		while (j < n && pooled[j].first == pooled[i].first)
+			j++;
+		double rank = 0.5 * (double)(i + 1 + j);
+		double ties = (double)(j - i);
+		tieTerm += ties * ties * ties - ties;
+		for (size_t k = i; k < j; k++)
+		{
+			if (pooled[k].second == 0)
+				rankSumA += rank;
+		}
+		i = j;
+	}
+
+	result.u = rankSumA - 0.5 * (double)n1 * (double)(n1 + 1);
+	double mean = 0.5 * (double)n1 * (double)n2;
+	double variance = (double)n1 * (double)n2 / 12.0 * ((double)(n + 1) - tieTerm / ((double)n * (double)(n - 1)));
+	if (variance <= 0.0)
+		return result;
+	// U counts pairs where a is larger, so b larger means U below its mean
+	double difference = mean - result.u;
+	double corrected = fabs(difference) > 0.5 ? fabs(difference) - 0.5 : 0.0;
+	result.z = (difference < 0.0 ? -corrected : corrected) / sqrt(variance);
+	result.p = erfc(fabs(result.z) / sqrt(2.0));
+	return result;
+}
+
+inline double median(std::vector<double> values)
+{
+	if (values.empty())
+		return 0.0;
+	size_t middle = values.size() / 2;
+	std::nth_element(values.begin(), values.begin() + middle, values.end());
+	double upper = values[middle];
+	if (values.size() % 2 == 1)
+		return upper;
+	return 0.5 * (upper + *std::max_element(values.begin(), values.begin() + middle));
+}
@@ -4,14 +4,43 @@
 
 #include "shader/shader.h"
 #include "util/performanceMonitor.h"
+#include "util/fetchBenchmark.h"
+#include "util/gpuTimer.h"
+#include "util/profiler.h"
+#include "util/profileHistory.h"
+#include "util/renderStats.h"
+#define ALLOC_TRACKER_IMPLEMENTATION
+#include "util/allocTracker.h"
+#include "util/memoryStats.h"
+#include "util/importBenchmark.h"
+#include "util/lodBenchmark.h"
+#include "util/arenaBenchmark.h"
+#include "util/frameArena.h"
+#include "util/sceneBenchmark.h"
+#include "util/shaderManager.h"
+#include "util/shaderPermutations.h"
+#include "util/shaderHotReload.h"
+#include "util/seaWaveBake.h"
+#include "util/seaLoop.h"
+#include "util/bakeBenchmark.h"
+#include "util/seaPatches.h"
+#include "util/primitiveCounter.h"
+#include "util/tessBenchmark.h"
+#include "util/detailBenchmark.h"
+#include "util/seaWaveFilter.h"
+#include "util/filterBenchmark.h"
+#include "util/launchOptions.h"
 #include "util/camera3d.h"
 #include "util/model.h"
 #include "util/shipMovement.h"
-#include <glm/gtx/norm.hpp >
+#include "util/seaMesh.h"
+#include "util/skyColor.h"
+#include <glm/gtx/norm.hpp>
 
 #include "menu.h"
 
 #include <iostream>
+#include <memory>
 
 using namespace std;
 
@@ -20,9 +49,17 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window, bool* fill);
-void createSeaMesh(float*& vertices, unsigned int*& indices, unsigned int N, glm::vec3 initPos, glm::vec3 finalPos, float sizeUV);
-glm::vec3 GetSkyColor(float cenit);
-unsigned int loadTexture(string path, GLuint mode);
+unsigned int loadTexture(string path);
+unsigned int seaPermutation(const glm::vec4& waveA, const glm::vec4& waveB, const glm::vec4& waveC, const displace& disA, const displace& disB, const displace& disC, unsigned int bakeKey, float detailWavelength, bool waveFilter, glm::vec4* activeWaves, unsigned int* activeCount);
+// seaShaders key bits of SEA_BAKED: the waves baked every frame (SeaWaveBake) or a baked loop (SeaLoop)
+const unsigned int seaBakedKey = 1u << 8;
+const unsigned int seaLoopKey = 2u << 8;
+// first seaShaders key bit of DETAIL_WAVES, the count of waves only bending the normal
+const unsigned int seaDetailShift = 10;
+// seaShaders key bits of WAVE_FILTER, and of COUNT_WAVES for --filter-benchmark
+const unsigned int seaFilterKey = 1u << 12;
+const unsigned int seaCountWavesKey = 1u << 13;
+void prepareSeaPresets(ShaderPermutations& seaShaders, unsigned int bakeKey, float detailWavelength, bool waveFilter);
 
 // settings
 const unsigned int SCR_WIDTH = 1024;
@@ -40,7 +77,7 @@ float deltaTime = 0.0f;	// time between current frame and last frame
 bool globaLView = true;
 string viewName;
 
-int main()
+int main(int argc, char** argv)
 {
     // glfw: initialize and configure
     // ------------------------------
@@ -77,21 +114,138 @@ int main()
         return -1;
     }
 
+    // the command line, each option is described in LaunchOptions
+    LaunchOptions options(argc, argv);
+    if (!options.traceFile.empty())
+        Profiler::instance().setEnabled(true);
+    if (!options.programCache)
+        ProgramCache::instance().setEnabled(false);
+
+    // --import-benchmark: time serial vs parallel model import on a synthetic scene and exit
+    if (options.importBenchmarkMeshes > 0)
+    {
+        runImportBenchmark(options.importBenchmarkMeshes, 5000);
+        glfwTerminate();
+        return 0;
+    }
+
+    // --arena-benchmark: time transient per frame containers on the default allocator and on a frame arena, then exit
+    if (options.arenaBenchmarkFrames > 0)
+    {
+        runArenaBenchmark(options.arenaBenchmarkFrames);
+        glfwTerminate();
+        return 0;
+    }
+
+    // --sea-tess takes the place of --sea-loop, and --sea-loop of --sea-bake; --sea-detail makes the grid coarser unless the waves are baked
+    unique_ptr<SeaWaveFilter> seaFilter;
+    if (options.seaFilterPixels > 0.0f)
+        seaFilter.reset(new SeaWaveFilter(options.seaFilterPixels));
+    unsigned int seaSize = 512;
+    unsigned int seaBakeKey = options.seaTessPixelError > 0.0f ? 0 : (options.seaLoopFrames > 0 ? seaLoopKey : (options.seaBakeResolution > 0 ? seaBakedKey : 0));
+    if (options.seaDetailWavelength > 0.0f && !seaBakeKey)
+        seaSize = options.seaDetailGrid ? options.seaDetailGrid : seaGridSize(64.0f, options.seaDetailWavelength, 8.0f);
+
     // configure global opengl state
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
 
     // build and compile our shader program
     // ------------------------------------
-    Shader shipShader("shader/shipShader.vs", "shader/shipShader.fs"); // you can name your shader files however you like
-    Model shipModel("../assets/viking_ship/ship.obj");
+    // every program is submitted up front and compiles while the model and textures load
+    ShaderManager shaders((GLADloadproc)glfwGetProcAddress);
+    Shader& shipShader = shaders.add("shader/shipShader.vs", "shader/shipShader.fs"); // you can name your shader files however you like
+    // Shader para el mar, specialised to the sea settings (seaPermutation); the variants of the Menu presets are compiled now
+    std::vector<PermutationFeature> seaFeatures = {
+        { "WAVE_COUNT", 2 },
+        { "DIS_A", 1 }, { "DIS_A_INSIDE", 1 },
+        { "DIS_B", 1 }, { "DIS_B_INSIDE", 1 },
+        { "DIS_C", 1 }, { "DIS_C_INSIDE", 1 },
+        { "SEA_BAKED", 2 },
+        { "DETAIL_WAVES", 2 },
+        { "WAVE_FILTER", 1 },
+        { "COUNT_WAVES", 1 } };
+    ShaderPermutations seaShaders(shaders, "shader/seaShader.vs", "shader/seaShader.fs", seaFeatures);
+    prepareSeaPresets(seaShaders, seaBakeKey, options.seaDetailWavelength, seaFilter != NULL);
+    // the same variants with the waves displaced in the tessellation evaluation shader, only when asked for
+    unique_ptr<ShaderPermutations> seaTessShaders;
+    if (options.seaTessPixelError > 0.0f || options.tessBenchmarkFrames > 0 || options.filterBenchmarkFrames > 0)
+    {
+        seaTessShaders.reset(new ShaderPermutations(shaders, "shader/seaTess.vs", "shader/seaTess.tcs", "shader/seaTess.tes", "shader/seaShader.fs", seaFeatures));
+        prepareSeaPresets(*seaTessShaders, 0, options.seaDetailWavelength, seaFilter != NULL);
+    }
+    Shader& sunShader = shaders.add("shader/MVPTexShader.vs", "shader/MVPTexShader.fs");
+
+    // --fetch-benchmark: vertex data size and vertex fetch throughput of the ship and a 10M triangle model in each vertex format, then exit
+    if (options.fetchBenchmarkPasses > 0)
+    {
+        shaders.finish();
+        runFetchBenchmark(shipShader, "../assets/viking_ship/ship.obj", 10000000, options.fetchBenchmarkPasses);
+        glfwTerminate();
+        return 0;
+    }
+
+    // --lod-benchmark: triangles and frame time of a fleet with and without LOD selection and cluster culling, then exit
+    if (options.lodBenchmarkShips > 0)
+    {
+        Model fleetShip("../assets/viking_ship/ship.obj", false, VERTEX_QUANTISED, false, false, 5, true);
+        shaders.finish();
+        runLodBenchmark(fleetShip, shipShader, SCR_WIDTH, SCR_HEIGHT, options.lodBenchmarkShips);
+        glfwTerminate();
+        return 0;
+    }
+
+    // --bake-benchmark: GPU time of the sea with per vertex waves and with the compute bake, over grid sizes and wave counts, then exit
+    if (options.bakeBenchmarkFrames > 0)
+    {
+        shaders.finish();
+        runBakeBenchmark(seaShaders, seaBakedKey, SCR_WIDTH, SCR_HEIGHT, options.bakeBenchmarkFrames);
+        glfwTerminate();
+        return 0;
+    }
+
+    // --tess-benchmark: triangles and frame time of the sea as a fixed grid and tessellated, from a few views, then exit
+    if (options.tessBenchmarkFrames > 0)
+    {
+        shaders.finish();
+        runTessBenchmark(seaShaders, *seaTessShaders, 3, 3, SCR_WIDTH, SCR_HEIGHT, 512, 32, options.tessBenchmarkFrames);
+        seaTessShaders.reset();
+        glfwTerminate();
+        return 0;
+    }
+
+    // --detail-benchmark: vertices the sea needs for the same image error with the short waves displacing the mesh and
+    // only bending the normal, then exit
+    if (options.detailBenchmarkWavelength > 0.0f)
+    {
+        shaders.finish();
+        runDetailBenchmark(seaShaders, seaDetailShift, SCR_WIDTH, SCR_HEIGHT, options.detailBenchmarkWavelength, options.detailBenchmarkTolerance);
+        glfwTerminate();
+        return 0;
+    }
+
+    // --filter-benchmark: waves evaluated per vertex and per fragment, frame time and image error of the sea with and
+    // without the waves too short for where they are evaluated, from a few views, then exit
+    if (options.filterBenchmarkFrames > 0)
+    {
+        shaders.finish();
+        runFilterBenchmark(seaShaders, *seaTessShaders, seaFilter ? *seaFilter : SeaWaveFilter(), seaFilterKey, seaCountWavesKey, seaDetailShift,
+            SCR_WIDTH, SCR_HEIGHT, seaSize, options.filterBenchmarkFrames);
+        seaTessShaders.reset();
+        glfwTerminate();
+        return 0;
+    }
 
-    // Shader para el mar
-    Shader seaShader("shader/seaShader.vs", "shader/seaShader.fs");
+    double importStart = glfwGetTime();
+    Model shipModel("../assets/viking_ship/ship.obj", false, VERTEX_QUANTISED, false, false, 5, true);
+    double importTime = glfwGetTime() - importStart;
+    shaders.poll();
+    cout << "Ship vertex data: " << shipModel.vertexBufferSize() / 1024 << " KB ("
+        << shipModel.unpackedVertexBufferSize() / 1024 << " KB unpacked)" << endl;
+    cout << "Ship import: " << importTime * 1000.0 << " ms, peak RSS " << peakResidentSetSize() / (1024 * 1024) << " MB" << endl;
 
     float* seaVertices;
     unsigned int* seaIndices;
-    unsigned int seaSize = 512;
     createSeaMesh(seaVertices, seaIndices, seaSize, glm::vec3(-32.0f, -32.0f, 0.0f), glm::vec3(32.0f, 32.0f, 0.0f), 1.0f);
     unsigned int seaVBO, seaVAO, seaEBO;
     glGenVertexArrays(1, &seaVAO);
@@ -112,21 +266,12 @@ int main()
     // texture coord attribute
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+    shaders.poll();
 
     // load and create a texture 
     // -------------------------
-    unsigned int texture1 = loadTexture("../assets/water2.png", GL_RGBA);
-    unsigned int texture2 = loadTexture("../assets/displacement1.jpg", GL_RGB);
-
-    // tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
-    // -------------------------------------------------------------------------------------------
-    seaShader.use(); // don't forget to activate/use the shader before setting uniforms!
-    seaShader.setInt("texture_tmp", 0);
-    seaShader.setInt("texture_dist", 1);
-
-    // build and compile our shader zprogram
-    // ------------------------------------
-    Shader sunShader("shader/MVPTexShader.vs", "shader/MVPTexShader.fs");
+    unsigned int texture1 = loadTexture("../assets/water2.png");
+    unsigned int texture2 = loadTexture("../assets/displacement1.jpg");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -163,7 +308,40 @@ int main()
 
     // load and create a texture 
     // -------------------------
-    unsigned int texture3 = loadTexture("../assets/sun2.png", GL_RGBA);
+    unsigned int texture3 = loadTexture("../assets/sun2.png");
+
+    // everything else is loaded, whatever is still compiling is waited for here
+    shaders.finish();
+
+    // --hot-reload: rebuild programs in the background when their files in shader/ change
+    unique_ptr<ShaderHotReload> hotReload;
+    if (options.hotReload)
+        hotReload.reset(new ShaderHotReload(shaders, window, "shader"));
+
+    // the bake covers the sea mesh, so at the mesh's resolution every vertex reads its own texel
+    unique_ptr<SeaWaveBake> seaBake;
+    unique_ptr<SeaLoop> seaLoop;
+    if (seaBakeKey == seaLoopKey)
+    {
+        seaLoop.reset(new SeaLoop(options.seaLoopFrames, options.seaLoopResolution, glm::vec2(-32.0f, -32.0f), glm::vec2(64.0f, 64.0f)));
+        cout << "Sea loop: " << seaLoop->getFrameCount() << " frames at " << options.seaLoopResolution << "x" << options.seaLoopResolution << ", "
+            << seaLoop->textureBytes() / (1024 * 1024) << " MB" << endl;
+    }
+    else if (seaBakeKey == seaBakedKey)
+    {
+        seaBake.reset(new SeaWaveBake(options.seaBakeResolution, glm::vec2(-32.0f, -32.0f), glm::vec2(64.0f, 64.0f)));
+        cout << "Sea waves baked at " << options.seaBakeResolution << "x" << options.seaBakeResolution << ", " << seaBake->textureBytes() / 1024 << " KB" << endl;
+    }
+    // patches 2 units wide; the triangles they make are counted on the GPU
+    unique_ptr<SeaPatches> seaPatches;
+    unique_ptr<PrimitiveCounter> seaPrimitives;
+    if (options.seaTessPixelError > 0.0f)
+    {
+        seaPatches.reset(new SeaPatches(32, glm::vec3(-32.0f, -32.0f, 0.0f), glm::vec3(32.0f, 32.0f, 0.0f), 1.0f));
+        seaPatches->pixelError = options.seaTessPixelError;
+        seaPrimitives.reset(new PrimitiveCounter());
+        cout << "Sea tessellated from " << seaPatches->getPatchCount() << " patches, " << seaPatches->bufferBytes() / 1024 << " KB" << endl;
+    }
 
     sunShader.use(); // don't forget to activate/use the shader before setting uniforms!
     sunShader.setInt("texture1", 0);
@@ -210,6 +388,39 @@ int main()
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     PerformanceMonitor pMonitor(glfwGetTime(), 0.5f);
+    unsigned int inputStage = pMonitor.addStage("input");
+    unsigned int shipStage = pMonitor.addStage("ship");
+    unsigned int seaStage = pMonitor.addStage("sea");
+    unsigned int sunStage = pMonitor.addStage("sun");
+    unsigned int uiStage = pMonitor.addStage("ui");
+    unsigned int swapStage = pMonitor.addStage("swap");
+
+    // CPU scopes of the last frames and the GL counters, for the profiler window
+    ProfileHistory profileHistory;
+    size_t seaBufferBytes = (size_t)seaSize * seaSize * 5 * sizeof(float) + (size_t)(seaSize - 1) * (seaSize - 1) * 6 * sizeof(unsigned int);
+
+    // --alloc-check and --benchmark measure as many frames as the machine renders, not the display's refresh rate
+    if (options.allocCheck || options.benchmark)
+        glfwSwapInterval(0);
+
+    const unsigned int allocCheckWarmup = 600;
+    unsigned int frameNumber = 0;
+    unsigned int allocatingFrames = 0;
+    FrameAllocations frameAllocations;
+    char windowTitle[128] = "";
+    char shownTitle[128] = "";
+
+    // GPU time of each pass, read back a few frames late so it never stalls
+    GpuTimer gpuTimer;
+    unsigned int framePass = gpuTimer.addPass("frame");
+    unsigned int shipPass = gpuTimer.addPass("ship");
+    unsigned int seaPass = gpuTimer.addPass("sea");
+    unsigned int seaBakePass = seaBakeKey ? gpuTimer.addPass("sea bake") : 0;
+    unsigned int sunPass = gpuTimer.addPass("sun");
+    unsigned int uiPass = gpuTimer.addPass("ui");
+    unique_ptr<SceneBenchmark> benchmark;
+    if (options.benchmark)
+        benchmark.reset(new SceneBenchmark(framePass));
 
     glm::vec2 mSize = { 800, 800 };
     bool fillPolygon = true;
@@ -273,20 +484,82 @@ int main()
 
     // render loop
     // -----------
+    bool firstFrame = true;
+    const Shader* lastSeaShader = NULL;
+    unsigned int lastSeaProgram = 0;
     while (!glfwWindowShouldClose(window))
     {
+        PROFILE_SCOPE("frame");
+        frameAllocations.beginFrame();
+        FrameArena::shared().beginFrame();
+        if (hotReload)
+            hotReload->update();
+        // the counts are of the frame before, the one numbered frameNumber - 1
+        if (options.allocCheck && ++frameNumber > allocCheckWarmup + 1 && frameAllocations.getLastFrame() > 0)
+        {
+            if (allocatingFrames++ < 10)
+                cout << "ERROR::ALLOC_CHECK::FRAME_ALLOCATED frame " << frameNumber - 1 << ": " << frameAllocations.getLastFrame() << " allocations" << endl;
+        }
+        if (options.allocCheck && frameNumber > allocCheckWarmup + options.allocCheckFrames)
+            break;
+        profileHistory.update();
+        RenderStats::instance().beginFrame();
         t0 = glfwGetTime();
         deltaTime = t1 - t0;
         t1 = t0;
 
+        pMonitor.setGpuFrameMs(gpuTimer.getLastMs(framePass));
         pMonitor.update(t1);
-        stringstream ss;
-        ss << title << " " << pMonitor;
-        glfwSetWindowTitle(window, ss.str().c_str());
+        gpuTimer.beginFrame();
+        gpuTimer.begin(framePass);
+        // the title only changes when the monitor refreshes its averages
+        snprintf(windowTitle, sizeof(windowTitle), "%s [%.2f fps - %.2f ms]", title.c_str(), pMonitor.getFPS(), pMonitor.getMS());
+        if (strcmp(windowTitle, shownTitle) != 0)
+        {
+            glfwSetWindowTitle(window, windowTitle);
+            strcpy(shownTitle, windowTitle);
+        }
 
         // input
         // -----
-        processInput(window, &fillPolygon);
+        pMonitor.stageBegin(inputStage);
+        PROFILE_BEGIN(input, "input");
+        float simTime = t1;
+        if (benchmark)
+        {
+            if (!benchmark->nextFrame(pMonitor, gpuTimer, RenderStats::instance().getLastFrame(), frameAllocations.getLastFrame()))
+                break;
+            if (benchmark->isSegmentStart())
+            {
+                Menu::applyConfig(benchmark->getPreset(), &gravity, &wave_A, &wave_B, &wave_C, &water_color, &water_ambient, &water_diffuse, &water_specular, &water_shininess,
+                    &disA, &disB, &disC, &sun_cenit, &sun_azim, &light_ambient, &light_diffuse, &light_specular);
+                // as Menu::setView switches views
+                globaLView = !benchmark->isShipView();
+                ship_pos.z = globaLView ? 0.0f : 2.0f;
+            }
+            // one turn round the scene per segment, bobbing up and down in the global view
+            float path = benchmark->getPathPosition();
+            float swing = glm::sin(2.0f * glm::pi<float>() * path);
+            if (globaLView)
+            {
+                camera.Center = glm::vec3(0.0f);
+                camera.Radius = 30.0f;
+                camera.Phi = 360.0f * path;
+                camera.Theta = 50.0f + 15.0f * swing;
+            }
+            else
+            {
+                shipMovement.Phi = 360.0f * path;
+                ship_rotation = 34.1f + 45.0f * swing;
+            }
+            simTime = benchmark->getTime();
+        }
+        else
+        {
+            processInput(window, &fillPolygon);
+        }
+        PROFILE_END(input);
+        pMonitor.stageEnd(inputStage);
 
         // prerender openglcontext
         // ------
@@ -318,10 +591,46 @@ int main()
             -glm::sin(theta) * glm::sin(phi),
             -glm::cos(theta));
 
+        // the sea's waves and variant ahead of the ship, which rides the looped waves with --sea-loop
+        pMonitor.stageBegin(seaStage);
+        PROFILE_BEGIN(seaWaves, "sea waves");
+        glm::vec4 seaWaves[3];
+        unsigned int seaWaveCount;
+        unsigned int seaKey = seaPermutation(wave_A, wave_B, wave_C, disA, disB, disC, seaBakeKey, options.seaDetailWavelength, seaFilter != NULL, seaWaves, &seaWaveCount);
+        if (seaBake)
+        {
+            gpuTimer.begin(seaBakePass);
+            seaBake->bake(gravity, simTime, seaWaves, seaWaveCount);
+            gpuTimer.end(seaBakePass);
+        }
+        if (seaLoop)
+        {
+            // the whole loop again, only when the waves changed
+            gpuTimer.begin(seaBakePass);
+            if (seaLoop->update(gravity, seaWaves, seaWaveCount) && seaLoop->getBakeCount() == 1)
+                cout << "Sea loop: " << seaLoop->getPeriod() << " s period, wavelengths changed up to "
+                    << seaLoop->getWavelengthError() * 100.0f << "%" << endl;
+            gpuTimer.end(seaBakePass);
+        }
+        PROFILE_END(seaWaves);
+        pMonitor.stageEnd(seaStage);
+
+        PROFILE_BEGIN(waves, "wave evaluation");
+        glm::vec4 shipWaves[3] = { wave_A, wave_B, wave_C };
+        float shipTime = simTime;
+        if (seaLoop)
+        {
+            // the wavelengths and time the loop plays, or the ship drifts out of phase with the water under it
+            for (unsigned int i = 0; i < 3; i++)
+                shipWaves[i] = seaLoop->loopWave(shipWaves[i]);
+            shipTime = seaLoop->loopTime(simTime);
+        }
         glm::vec3 p = ship_pos;
-        p += shipMovement.GerstnerWave(wave_A, ship_pos, ship_tangent, ship_binormal, gravity, t1);
-        p += shipMovement.GerstnerWave(wave_B, ship_pos, ship_tangent, ship_binormal, gravity, t1);
-        p += shipMovement.GerstnerWave(wave_C, ship_pos, ship_tangent, ship_binormal, gravity, t1);
+        p += shipMovement.GerstnerWave(shipWaves[0], ship_pos, ship_tangent, ship_binormal, gravity, shipTime);
+        p += shipMovement.GerstnerWave(shipWaves[1], ship_pos, ship_tangent, ship_binormal, gravity, shipTime);
+        p += shipMovement.GerstnerWave(shipWaves[2], ship_pos, ship_tangent, ship_binormal, gravity, shipTime);
+        PROFILE_END(waves);
+        PROFILE_BEGIN(shipUpdate, "ship update");
         ship_normal = glm::normalize(cross(ship_tangent, ship_binormal));
         glm::mat4 rotate = glm::mat4_cast(shipMovement.RotationBetweenVectors(
             glm::vec3(ship_tangent.x, ship_tangent.y, 0.0f),
@@ -332,11 +641,16 @@ int main()
             shipMovement.setPos(p);
             shipMovement.setTransform(rotate * glm::rotate(glm::mat4(1.0f), glm::radians(ship_rotation), glm::vec3(0.0f, 0.0f, 1.0f)));
         }
+        PROFILE_END(shipUpdate);
 
+        pMonitor.stageBegin(shipStage);
+        PROFILE_BEGIN(shipDraw, "ship draw");
+        gpuTimer.begin(shipPass);
         shipShader.use();
 
         // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(globaLView ? camera.Fovy : shipMovement.Fovy), (float)mSize.x / (float)mSize.y, 0.1f, 100.0f);
+        float fovy = glm::radians(globaLView ? camera.Fovy : shipMovement.Fovy);
+        glm::mat4 projection = glm::perspective(fovy, (float)mSize.x / (float)mSize.y, 0.1f, 100.0f);
         glm::mat4 view = globaLView ? camera.GetViewMatrix() : shipMovement.GetViewMatrix();
         shipShader.setMat4("projection", projection);
         shipShader.setMat4("view", view);
@@ -355,19 +669,46 @@ int main()
         model = glm::rotate(model, glm::radians(ship_rotation), glm::vec3(0.0f, 0.0f, 1.0f));
         model = glm::scale(model, 0.1f * glm::vec3(ship_size, ship_size, ship_size));
 
-        shipShader.setMat4("model", model);
         shipShader.setVec3("lightPos", -lightDirection);
-        shipModel.Draw(shipShader);
+        glm::vec3 viewPos = glm::vec3(glm::inverse(view)[3]);
+        shipModel.Draw(shipShader, model, projection * view, viewPos, Model::projectionScale(fovy, mSize.y));
+        gpuTimer.end(shipPass);
+        PROFILE_END(shipDraw);
+        pMonitor.stageEnd(shipStage);
 
         // Draw the sea
+        pMonitor.stageBegin(seaStage);
+        PROFILE_BEGIN(seaDraw, "sea draw");
+        gpuTimer.begin(seaPass);
+        Shader& seaShader = seaPatches ? seaTessShaders->get(seaKey) : seaShaders.get(seaKey);
         seaShader.use();
+        // tell opengl for each sampler to which texture unit it belongs to, once per variant and again once
+        // a hot reload has replaced its program
+        if (&seaShader != lastSeaShader || seaShader.ID != lastSeaProgram)
+        {
+            seaShader.setInt("texture_tmp", 0);
+            seaShader.setInt("texture_dist", 1);
+            if (seaBake)
+                seaBake->setUniforms(seaShader, 2, 3);
+            if (seaLoop)
+                seaLoop->setUniforms(seaShader, 2, 3);
+            lastSeaShader = &seaShader;
+            lastSeaProgram = seaShader.ID;
+        }
+        if (seaBake)
+            seaBake->bindTextures(2, 3);
+        if (seaLoop)
+        {
+            seaLoop->bindTextures(2, 3);
+            seaShader.setFloat("loopFrame", seaLoop->frameAt(simTime));
+        }
         // bind textures on corresponding texture units
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, texture1);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, texture2);
         seaShader.setVec3("light.direction", lightDirection);
-        seaShader.setVec3("viewPos", camera.Position);
+        seaShader.setVec3("viewPos", viewPos);
 
         // light properties
         glm::vec3 lightColor = glm::vec3(1.0f);
@@ -389,43 +730,75 @@ int main()
         // world transformation
         glm::mat4 seaModel = glm::mat4(1.0f);
         seaShader.setMat4("model", seaModel);
+        if (seaBakeKey || ((seaKey >> seaDetailShift) & 3u))
+            seaShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(seaModel))));
+
+        //wave properties, already in the textures of a baked variant
+        seaShader.setFloat("time", simTime);
+        if (!seaBakeKey)
+        {
+            seaShader.setFloat("gravity", gravity);
+            seaShader.setVec4("waveA", seaWaves[0]);
+            seaShader.setVec4("waveB", seaWaves[1]);
+            seaShader.setVec4("waveC", seaWaves[2]);
+        }
+        if (seaKey & seaFilterKey)
+            seaFilter->setUniforms(seaShader, Model::projectionScale(fovy, mSize.y), 64.0f / (float)(seaSize - 1));
+
+        // only the noise layers the variant has
+        if (seaKey & (1u << 2))
+        {
+            seaShader.setFloat("disASize", disA.size);
+            seaShader.setVec2("disADir", disA.direction);
+            seaShader.setFloat("disASpeed", disA.speed);
+            seaShader.setFloat("disAStrenght", disA.strenght);
+            seaShader.setVec3("disAColor", disA.color);
+            seaShader.setVec2("disADiscard", disA.discard);
+        }
 
-        //wave properties
-        seaShader.setFloat("gravity", gravity);
-        seaShader.setFloat("time", t1);
-        seaShader.setVec4("waveA", wave_A);
-        seaShader.setVec4("waveB", wave_B);
-        seaShader.setVec4("waveC", wave_C);
-
-        seaShader.setFloat("disASize", disA.size);
-        seaShader.setVec2("disADir", disA.direction);
-        seaShader.setFloat("disASpeed", disA.speed);
-        seaShader.setFloat("disAStrenght", disA.strenght);
-        seaShader.setVec3("disAColor", disA.color);
-        seaShader.setVec2("disADiscard", disA.discard);
-        seaShader.setBool("disAInside", disA.inside);
-
-        seaShader.setFloat("disBSize", disB.size);
-        seaShader.setVec2("disBDir", disB.direction);
-        seaShader.setFloat("disBSpeed", disB.speed);
-        seaShader.setFloat("disBStrenght", disB.strenght);
-        seaShader.setVec3("disBColor", disB.color);
-        seaShader.setVec2("disBDiscard", disB.discard);
-        seaShader.setBool("disBInside", disB.inside);
-
-        seaShader.setFloat("disCSize", disC.size);
-        seaShader.setVec2("disCDir", disC.direction);
-        seaShader.setFloat("disCSpeed", disC.speed);
-        seaShader.setFloat("disCStrenght", disC.strenght);
-        seaShader.setVec3("disCColor", disC.color);
-        seaShader.setVec2("disCDiscard", disC.discard);
-        seaShader.setBool("disCInside", disC.inside);
+        if (seaKey & (1u << 4))
+        {
+            seaShader.setFloat("disBSize", disB.size);
+            seaShader.setVec2("disBDir", disB.direction);
+            seaShader.setFloat("disBSpeed", disB.speed);
+            seaShader.setFloat("disBStrenght", disB.strenght);
+            seaShader.setVec3("disBColor", disB.color);
+            seaShader.setVec2("disBDiscard", disB.discard);
+        }
+
+        if (seaKey & (1u << 6))
+        {
+            seaShader.setFloat("disCSize", disC.size);
+            seaShader.setVec2("disCDir", disC.direction);
+            seaShader.setFloat("disCSpeed", disC.speed);
+            seaShader.setFloat("disCStrenght", disC.strenght);
+            seaShader.setVec3("disCColor", disC.color);
+            seaShader.setVec2("disCDiscard", disC.discard);
+        }
 
         // render the sea
-        glBindVertexArray(seaVAO);
-        glDrawElements(GL_TRIANGLES, (seaSize - 1) * (seaSize - 1) * 2 * 3, GL_UNSIGNED_INT, 0);
+        if (seaPatches)
+        {
+            seaPatches->setUniforms(seaShader, seaWaves, seaWaveCount, Model::projectionScale(fovy, mSize.y));
+            seaPrimitives->begin();
+            seaPatches->draw();
+            seaPrimitives->end();
+            RenderStats::instance().draw(seaPrimitives->getLast());
+        }
+        else
+        {
+            glBindVertexArray(seaVAO);
+            glDrawElements(GL_TRIANGLES, (seaSize - 1) * (seaSize - 1) * 2 * 3, GL_UNSIGNED_INT, 0);
+            RenderStats::instance().draw((seaSize - 1) * (seaSize - 1) * 2);
+        }
+        gpuTimer.end(seaPass);
+        PROFILE_END(seaDraw);
+        pMonitor.stageEnd(seaStage);
 
         // Render the sun
+        pMonitor.stageBegin(sunStage);
+        PROFILE_BEGIN(sunDraw, "sun draw");
+        gpuTimer.begin(sunPass);
         // activate shader
         sunShader.use();
         // bind textures on corresponding texture units
@@ -448,10 +821,16 @@ int main()
         sunShader.setVec3("pos", -lightDirection * 40.0f);
 
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        RenderStats::instance().draw(2);
+        gpuTimer.end(sunPass);
+        PROFILE_END(sunDraw);
+        pMonitor.stageEnd(sunStage);
 
         // unbind framebuffer
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+        pMonitor.stageBegin(uiStage);
+        PROFILE_BEGIN(ui, "imgui");
         mSize = guiMenu.begin(mTexId);
         guiMenu.setShip(&ship_pos, &ship_size, &ship_rotation);
 
@@ -465,6 +844,10 @@ int main()
 
         guiMenu.setView(&globaLView, &ship_pos);
 
+        guiMenu.setPerformance(pMonitor, gpuTimer);
+
+        guiMenu.setProfiler(profileHistory, gpuTimer, shipModel.vertexBufferSize() + seaBufferBytes, frameAllocations.getLastFrame());
+
         guiMenu.config1(&gravity, &wave_A, &wave_B, &wave_C, &water_color, &water_ambient, &water_diffuse, &water_specular, &water_shininess, &disA, &disB, &disC, &sun_cenit, &sun_azim,
             &light_ambient, &light_diffuse, &light_specular);
         guiMenu.config2(&gravity, &wave_A, &wave_B, &wave_C, &water_color, &water_ambient, &water_diffuse, &water_specular, &water_shininess, &disA, &disB, &disC, &sun_cenit, &sun_azim,
@@ -474,15 +857,34 @@ int main()
         guiMenu.config4(&gravity, &wave_A, &wave_B, &wave_C, &water_color, &water_ambient, &water_diffuse, &water_specular, &water_shininess, &disA, &disB, &disC, &sun_cenit, &sun_azim,
             &light_ambient, &light_diffuse, &light_specular);
 
+        gpuTimer.begin(uiPass);
         guiMenu.endRender();
-
+        gpuTimer.end(uiPass);
+        gpuTimer.end(framePass);
+        PROFILE_END(ui);
+        pMonitor.stageEnd(uiStage);
 
         // Render end, swap buffers
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
+        pMonitor.stageBegin(swapStage);
+        PROFILE_BEGIN(swap, "swap");
         glfwPollEvents();
         glfwSwapBuffers(window);
+        PROFILE_END(swap);
+        pMonitor.stageEnd(swapStage);
+
+        // from glfwInit to the first frame handed to the driver
+        if (firstFrame)
+        {
+            firstFrame = false;
+            const ProgramCache& programCache = ProgramCache::instance();
+            cout << "Time to first frame: " << glfwGetTime() * 1000.0 << " ms, shaders " << programCache.getBuildMs() << " ms ("
+                << programCache.getHits() << " from the program cache, " << programCache.getMisses() << " compiled"
+                << (programCache.isEnabled() ? "" : ", cache disabled") << "), waited " << shaders.getWaitedMs() << " ms for compiles"
+                << (shaders.isParallel() ? " (parallel compile)" : "") << endl;
+        }
     }
 
     // optional: de-allocate all resources once they've outlived their purpose:
@@ -492,11 +894,29 @@ int main()
     //glDeleteBuffers(1, &EBO);
 
     guiMenu.destroy();
+    // stops the reload thread while its context still exists
+    hotReload.reset();
+    seaBake.reset();
+    seaLoop.reset();
+    seaPatches.reset();
+    seaPrimitives.reset();
+
+    if (benchmark)
+        benchmark->writeJson(options.benchmarkFile, pMonitor, gpuTimer);
+
+    if (!options.traceFile.empty())
+        Profiler::instance().writeChromeTrace(options.traceFile);
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwDestroyWindow(window);
     glfwTerminate();
+    if (options.allocCheck)
+    {
+        cout << "Allocation check: " << allocatingFrames << " of " << (frameNumber > allocCheckWarmup + 1 ? frameNumber - allocCheckWarmup - 1 : 0)
+            << " frames past the warm-up allocated" << endl;
+        return allocatingFrames > 0 ? 1 : 0;
+    }
     return 0;
 }
 
@@ -610,93 +1030,67 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
     }
 }
 
-void createSeaMesh(float*& vertices, unsigned int*& indices, unsigned int N, glm::vec3 initPos, glm::vec3 finalPos, float sizeUV) {
-    int vertexSize = 5;
-    int indexSize = 3;
-    float xGap = (finalPos.x - initPos.x) / ((float)N - 1.0f);
-    float yGap = (finalPos.y - initPos.y) / ((float)N - 1.0f);
-    vertices = new float[N * N * vertexSize];
-    indices = new unsigned int[(N - 1) * (N - 1) * 2 * indexSize];
-
-    for (unsigned int j = 0; j < N; j++) {
-        for (unsigned int i = 0; i < N; i++) {
-            float tempv[] = {
-                initPos.x + i * xGap, initPos.y + j * yGap, initPos.z,
-                0.0f + ((float)i / (float)N) * sizeUV, sizeUV - ((float)j / (float)N) * sizeUV };
-            copy(tempv, tempv + (1 * vertexSize), (vertices + (j * N + i) * vertexSize));
-
-            if ((j < N - 1) && (i < N - 1)) {
-                unsigned int tempi[] = {
-                    (j * N + i), (j * N + (i + 1)), ((j + 1) * N + (i + 1)),
-                    ((j + 1) * N + (i + 1)), ((j + 1) * N + (i + 0)), ((j + 0) * N + (i + 0)) };
-                copy(tempi, tempi + (2 * indexSize), (indices + (j * (N - 1) + i) * 2 * indexSize));
-            }
-        }
-    }
+// textures go through the same cache as the model ones, so a file shared with a model is only loaded once
+unsigned int loadTexture(string path) {
+    // repeat wrapping, linear filtering, with mipmaps generated
+    return TextureCache::instance().acquire(path, TextureSettings(GL_REPEAT, GL_LINEAR, GL_LINEAR, true));
 }
 
-glm::vec3 InterpColor(glm::vec3 color1, glm::vec3 color2, float t)
+// The cheapest sea shader variant for the settings, as a key of seaShaders. Waves without steepness are
+// flat and left out, the ones that remain are packed into activeWaves longest first and counted in
+// activeCount; a noise layer without strength or color, or whose range keeps nothing, is switched off.
+// With a bakeKey (seaBakedKey, seaLoopKey) the variant reads the waves from textures, whatever their
+// count. Otherwise the waves shorter than detailWavelength only bend the normal: they are the last ones,
+// after the activeCount displacing the mesh, as DETAIL_WAVES. waveFilter leaves out the waves too short
+// for where they are evaluated (SeaWaveFilter).
+unsigned int seaPermutation(const glm::vec4& waveA, const glm::vec4& waveB, const glm::vec4& waveC, const displace& disA, const displace& disB, const displace& disC, unsigned int bakeKey, float detailWavelength, bool waveFilter, glm::vec4* activeWaves, unsigned int* activeCount)
 {
-    return color1 * (1.0f - t) + color2 * t;
-}
-
-glm::vec3 GetSkyColor(float cenit) {
-    glm::vec3 color1 = glm::vec3(0.701f, 1.0f, 0.996f);
-    glm::vec3 color2 = glm::vec3(0.345f, 0.796f, 0.996f);
-    glm::vec3 color3 = glm::vec3(1.0f, 0.682f, 0.180f);
-    glm::vec3 color4 = glm::vec3(0.929f, 0.349f, 0.007f);
-    glm::vec3 color5 = glm::vec3(0.003f, 0.031f, 0.517f);
-    glm::vec3 color6 = glm::vec3(0.0f);
-
-    glm::vec3 skyColor = glm::vec3(1.0f);
-    float middleDay = 0.0f;
-    float afternoon = 60.0f;
-    float sunsetStart = 70.0f;
-    float sunsetMiddle = 80.0f;
-    float sunsetEnd = 95.0f;
-    float midnight = 180.0f;
-
-    if (cenit < afternoon) {
-        skyColor = InterpColor(color1, color2, cenit / (afternoon - middleDay));
-    }
-    else if (cenit < sunsetStart) {
-        skyColor = InterpColor(color2, color3, (cenit - afternoon) / (sunsetStart - afternoon));
-    }
-    else if (cenit < sunsetMiddle) {
-        skyColor = InterpColor(color3, color4, (cenit - sunsetStart) / (sunsetMiddle - sunsetStart));
-    }
-    else if (cenit < sunsetEnd) {
-        skyColor = InterpColor(color4, color5, (cenit - sunsetMiddle) / (sunsetEnd - sunsetMiddle));
-    }
-    else {
-        skyColor = InterpColor(color5, color6, (cenit - sunsetEnd) / (midnight - sunsetEnd));
+    const glm::vec4* waves[3] = { &waveA, &waveB, &waveC };
+    unsigned int waveCount = 0;
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        if (waves[i]->z != 0.0f)
+            activeWaves[waveCount++] = *waves[i];
     }
+    for (unsigned int i = waveCount; i < 3; i++)
+        activeWaves[i] = glm::vec4(0.0f);
+    SeaWaveFilter::sortByWavelength(activeWaves, waveCount);
 
-    return skyColor;
-}
+    unsigned int detailCount = 0;
+    if (!bakeKey && detailWavelength > 0.0f)
+    {
+        while (detailCount < waveCount && activeWaves[waveCount - 1 - detailCount].w < detailWavelength)
+            detailCount++;
+    }
+    waveCount -= detailCount;
+    *activeCount = waveCount;
 
-unsigned int loadTexture(string path, GLuint mode) {
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    // set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load image, create texture and generate mipmaps
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (data)
+    unsigned int key = bakeKey ? bakeKey : (waveCount | (detailCount << seaDetailShift) | (waveFilter ? seaFilterKey : 0));
+    const displace* layers[3] = { &disA, &disB, &disC };
+    for (unsigned int i = 0; i < 3; i++)
     {
-        glTexImage2D(GL_TEXTURE_2D, 0, mode, width, height, 0, mode, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        const displace& layer = *layers[i];
+        // noise values are in [0, 1]: an empty range keeps nothing inside, one covering [0, 1] nothing outside
+        bool empty = layer.inside ? layer.discard.x >= layer.discard.y : (layer.discard.x <= 0.0f && layer.discard.y >= 1.0f);
+        bool enabled = layer.strenght != 0.0f && layer.color != glm::vec3(0.0f) && !empty;
+        if (enabled)
+            key |= (layer.inside ? 3u : 1u) << (2 + 2 * i);
     }
-    else
+    return key;
+}
+
+// submits the sea variants of the Menu presets, so the ones a preset switches to are ready
+void prepareSeaPresets(ShaderPermutations& seaShaders, unsigned int bakeKey, float detailWavelength, bool waveFilter)
+{
+    for (unsigned int preset = 1; preset <= 4; preset++)
     {
-        std::cout << "Failed to load texture" << std::endl;
+        float gravity, cenit, azim, ambient, diffuse, specular, shininess;
+        glm::vec4 waveA, waveB, waveC, activeWaves[3];
+        unsigned int activeCount;
+        glm::vec3 color, waterAmbient, waterDiffuse, waterSpecular;
+        displace disA, disB, disC;
+        Menu::applyConfig(preset, &gravity, &waveA, &waveB, &waveC, &color, &waterAmbient, &waterDiffuse, &waterSpecular, &shininess,
+            &disA, &disB, &disC, &cenit, &azim, &ambient, &diffuse, &specular);
+        seaShaders.prepare(seaPermutation(waveA, waveB, waveC, disA, disB, disC, bakeKey, detailWavelength, waveFilter, activeWaves, &activeCount));
     }
-    stbi_image_free(data);
-    return texture;
-}
\ No newline at end of file
+}
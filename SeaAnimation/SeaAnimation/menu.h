@@ -8,6 +8,18 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "util/performanceMonitor.h"
+#include "util/gpuTimer.h"
+#include "util/profiler.h"
+#include "util/profileHistory.h"
+#include "util/renderStats.h"
+#include "util/memoryStats.h"
+#include "util/frameArena.h"
+
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+
 
 struct displace {
     float size;
@@ -98,7 +110,7 @@ public:
         ImGui::DockSpace(dockSpaceId, ImVec2(0.0f, 0.0f), ImGuiDockNodeFlags_PassthruCentralNode);
         ImGui::End();
     }
-    void draw_vec3_widget(const std::string& label, glm::vec3& values, float columnWidth = 100.0f)
+    void draw_vec3_widget(const char* label, glm::vec3& values, float columnWidth = 100.0f)
     {
         ImGuiIO& io = ImGui::GetIO();
         auto boldFont = io.Fonts->Fonts[0];
@@ -311,8 +323,8 @@ public:
     }
 
     void setView(bool* globalView, glm::vec3* pos) {
-        string viewName = *globalView ? "Ship View" : "Global View";
-        if (ImGui::Button(viewName.c_str()))
+        const char* viewName = *globalView ? "Ship View" : "Global View";
+        if (ImGui::Button(viewName))
         {
             *globalView = !(*globalView);
             if (*globalView)
@@ -327,195 +339,406 @@ public:
         ImGui::Separator();
     }
 
+    void setPerformance(PerformanceMonitor& monitor, const GpuTimer& gpuTimer) {
+        if (ImGui::CollapsingHeader("Performance"))
+        {
+            ImGui::Separator();
+            ImGui::Text("CPU frame: %.2f ms (%.1f fps)", monitor.getMS(), monitor.getFPS());
+            const FrameStats& cpu = monitor.getCpuStats();
+            const FrameStats& gpu = monitor.getGpuStats();
+            ImGui::Text("CPU p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", cpu.p50, cpu.p95, cpu.p99, cpu.max);
+            ImGui::Text("GPU p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", gpu.p50, gpu.p95, gpu.p99, gpu.max);
+
+            // histogram of the frame times in the ring, refreshed with the stats
+            const std::vector<unsigned int>& histogram = monitor.getHistogram();
+            float counts[64];
+            unsigned int buckets = histogram.size() < 64 ? (unsigned int)histogram.size() : 64;
+            float highest = 0.0f;
+            for (unsigned int i = 0; i < buckets; i++)
+            {
+                counts[i] = (float)histogram[i];
+                highest = counts[i] > highest ? counts[i] : highest;
+            }
+            char label[64];
+            snprintf(label, sizeof(label), "%.0f ms buckets", monitor.getHistogramBucketMs());
+            ImGui::PlotHistogram("##frametimes", counts, buckets, 0, label, 0.0f, highest, ImVec2(0.0f, 60.0f));
+
+            ImGui::SliderFloat("Hitch factor", &monitor.hitchFactor, 1.5f, 10.0f);
+            unsigned int hitchCount = monitor.getHitchCount();
+            ImGui::Text("Hitches: %u", hitchCount);
+            for (unsigned int i = hitchCount > 5 ? hitchCount - 5 : 0; i < hitchCount; i++)
+            {
+                const Hitch& hitch = monitor.getHitch(i);
+                ImGui::BulletText("%.1f s: %.2f ms (median %.2f), %s", hitch.time, hitch.ms, hitch.medianMs, hitch.stage);
+            }
+
+            if (ImGui::Button("Export CSV"))
+                monitor.writeCsv("frame_times.csv");
+            ImGui::SameLine();
+            if (ImGui::Button("Export JSON"))
+                monitor.writeJson("frame_times.json");
+            ImGui::Separator();
+            for (unsigned int i = 0; i < gpuTimer.getPassCount(); i++)
+                ImGui::Text("GPU %s: %.3f ms", gpuTimer.getName(i).c_str(), gpuTimer.getAverageMs(i));
+            ImGui::Text("Late queries skipped: %u", gpuTimer.getSkipped());
+            ImGui::Separator();
+        }
+    }
+
+    // "Profiler" window: the recorded frames, a flame graph of the selected one, GPU pass and CPU stage
+    // times, GL submission counters and memory. Only draws what's visible and never allocates.
+    void setProfiler(const ProfileHistory& history, const GpuTimer& gpuTimer, size_t gpuBufferBytes, unsigned int frameAllocations) {
+        PROFILE_SCOPE("profiler panel");
+        std::chrono::steady_clock::time_point panelStart = std::chrono::steady_clock::now();
+        ImGui::Begin("Profiler");
+
+        Profiler& profiler = Profiler::instance();
+        bool recording = profiler.isEnabled();
+        if (ImGui::Checkbox("Record", &recording))
+            profiler.setEnabled(recording);
+        ImGui::SameLine();
+        if (ImGui::Button("Write trace.json"))
+            profiler.writeChromeTrace("trace.json");
+        ImGui::SameLine();
+        ImGui::Checkbox("Live", &profilerLive);
+        ImGui::SameLine();
+        ImGui::Text("panel %.3f ms", profilerPanelMs);
+
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+        float width = ImGui::GetContentRegionAvail().x;
+        if (width < 50.0f)
+            width = 50.0f;
+        unsigned int frameCount = history.size();
+
+        // the selected frame, followed by its start time since the ring moves every frame
+        int selected = frameCount > 0 ? (int)frameCount - 1 : -1;
+        if (!profilerLive)
+        {
+            for (unsigned int i = 0; i < frameCount; i++)
+            {
+                if (history.frame(i).startNs == profilerFrameStart)
+                    selected = (int)i;
+            }
+        }
+
+        // one bar per frame, the line marks 60 fps
+        const float budgetMs = 1000.0f / 60.0f;
+        float longestMs = budgetMs;
+        for (unsigned int i = 0; i < frameCount; i++)
+            longestMs = glm::max(longestMs, (float)(history.frame(i).durationNs * 1e-6));
+        ImVec2 stripOrigin = ImGui::GetCursorScreenPos();
+        const float stripHeight = 50.0f;
+        ImGui::InvisibleButton("##frames", ImVec2(width, stripHeight));
+        float barWidth = width / (float)history.capacity();
+        drawList->AddRectFilled(stripOrigin, ImVec2(stripOrigin.x + width, stripOrigin.y + stripHeight), IM_COL32(30, 30, 30, 255));
+        for (unsigned int i = 0; i < frameCount; i++)
+        {
+            float ms = (float)(history.frame(i).durationNs * 1e-6);
+            float x = stripOrigin.x + i * barWidth;
+            float top = stripOrigin.y + stripHeight * (1.0f - ms / longestMs);
+            ImU32 color = (int)i == selected ? IM_COL32(255, 255, 255, 255) : ms > budgetMs ? IM_COL32(220, 80, 60, 255) : IM_COL32(90, 180, 90, 255);
+            drawList->AddRectFilled(ImVec2(x, top), ImVec2(x + glm::max(barWidth - 1.0f, 1.0f), stripOrigin.y + stripHeight), color);
+        }
+        float budgetY = stripOrigin.y + stripHeight * (1.0f - budgetMs / longestMs);
+        drawList->AddLine(ImVec2(stripOrigin.x, budgetY), ImVec2(stripOrigin.x + width, budgetY), IM_COL32(200, 200, 200, 120));
+        if (ImGui::IsItemHovered() && frameCount > 0)
+        {
+            int hovered = (int)((mouse.x - stripOrigin.x) / barWidth);
+            if (hovered >= 0 && hovered < (int)frameCount)
+            {
+                ImGui::SetTooltip("%.2f ms", history.frame(hovered).durationNs * 1e-6);
+                if (ImGui::IsMouseClicked(0))
+                {
+                    profilerLive = false;
+                    profilerFrameStart = history.frame(hovered).startNs;
+                    selected = hovered;
+                }
+            }
+        }
+
+        // flame graph of the selected frame, one row per nesting level
+        if (selected >= 0)
+        {
+            const ProfiledFrame& frame = history.frame(selected);
+            unsigned int depth = 0;
+            for (unsigned int i = 0; i < frame.events.size(); i++)
+                depth = glm::max(depth, frame.events[i].depth + 1);
+            float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+            ImVec2 flameOrigin = ImGui::GetCursorScreenPos();
+            ImGui::InvisibleButton("##flame", ImVec2(width, depth * rowHeight));
+            bool hovered = ImGui::IsItemHovered();
+            float nsToPixels = width / (float)glm::max(frame.durationNs, (int64_t)1);
+            for (unsigned int i = 0; i < frame.events.size(); i++)
+            {
+                const ProfileEvent& event = frame.events[i];
+                ImVec2 low(flameOrigin.x + (event.startNs - frame.startNs) * nsToPixels, flameOrigin.y + event.depth * rowHeight);
+                ImVec2 high(glm::max(low.x + 1.0f, low.x + event.durationNs * nsToPixels), low.y + rowHeight - 1.0f);
+                ImU32 color = ImColor::HSV(0.08f * event.depth, 0.55f, 0.75f);
+                drawList->AddRectFilled(low, high, color);
+                ImVec4 clip(low.x, low.y, high.x - 2.0f, high.y);
+                drawList->AddText(NULL, 0.0f, ImVec2(low.x + 2.0f, low.y + 2.0f), IM_COL32(0, 0, 0, 255), event.name, NULL, 0.0f, &clip);
+                if (hovered && mouse.x >= low.x && mouse.x < high.x && mouse.y >= low.y && mouse.y < high.y)
+                    ImGui::SetTooltip("%s: %.3f ms, %u allocations", event.name, event.durationNs * 1e-6, event.allocations);
+            }
+
+            // CPU stages: the direct children of the frame scope, slowest first
+            FrameVector<const ProfileEvent*> stages{ ArenaAllocator<const ProfileEvent*>(FrameArena::shared()) };
+            stages.reserve(frame.events.size());
+            for (unsigned int i = 0; i < frame.events.size(); i++)
+            {
+                if (frame.events[i].depth == 1)
+                    stages.push_back(&frame.events[i]);
+            }
+            std::sort(stages.begin(), stages.end(), [](const ProfileEvent* a, const ProfileEvent* b) { return a->durationNs > b->durationNs; });
+            ImGui::Text("CPU stages");
+            for (unsigned int i = 0; i < stages.size(); i++)
+                drawTimeBar(stages[i]->name, (float)(stages[i]->durationNs * 1e-6), (float)(frame.durationNs * 1e-6));
+        }
+        else
+        {
+            ImGui::TextDisabled("Nothing recorded yet");
+        }
+
+        // GPU passes, the first one being the whole frame
+        ImGui::Text("GPU passes");
+        float gpuFrameMs = gpuTimer.getPassCount() > 0 ? gpuTimer.getAverageMs(0) : 0.0f;
+        for (unsigned int i = 0; i < gpuTimer.getPassCount(); i++)
+            drawTimeBar(gpuTimer.getName(i).c_str(), gpuTimer.getAverageMs(i), gpuFrameMs);
+
+        ImGui::Separator();
+        const RenderCounters& counters = RenderStats::instance().getLastFrame();
+        ImGui::Text("Draw calls %u  triangles %u  uniform uploads %u", counters.drawCalls, counters.triangles, counters.uniformUploads);
+        ImGui::Text("Heap allocations %u (render thread, last frame)", frameAllocations);
+        ImGui::Text("Frame arena %.1f of %.1f KB", FrameArena::shared().getUsed() / 1024.0, FrameArena::shared().getCapacity() / 1024.0);
+        ImGui::Text("Peak RSS %.1f MB  GPU buffers %.1f MB", peakResidentSetSize() / (1024.0 * 1024.0), gpuBufferBytes / (1024.0 * 1024.0));
+
+        ImGui::End();
+        profilerPanelMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - panelStart).count();
+    }
+
     void config1(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
         displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float *ls) {
         if (ImGui::Button("Configuration 1"))
-        {
-            *gr = 9.8f;
-            *wA = glm::vec4(-0.072f, 1.0f, 0.346f, 20.0f);
-            *wB = glm::vec4(0.855f, -0.536f, 0.417f, 12.814f);
-            *wC = glm::vec4(0.449f, 0.362f, 0.712f, 19.026f);
-
-            *wtClr = glm::vec3(0.279f, 0.528f, 1.0f);
-            *wtAm = glm::vec3(0.0f, 0.006f, 0.359f);
-            *wtDf = glm::vec3(0.05f, 0.165f, 0.65f);
-            *wtSp = glm::vec3(0.491f, 0.492f, 0.492f);
-            *wtSh = 67.0f;;
-
-            dA->size = 1.531f;
-            dA->direction = glm::vec2(1.0f);
-            dA->speed = 0.015f;
-            dA->strenght = 3.429f;
-            dA->color = glm::vec3(0.358f, 0.358f, 0.358f);
-            dA->discard = glm::vec2(0.269f, 0.333f);
-            dA->inside = true;
-
-            dB->size = 2.963f;
-            dB->direction = glm::vec2(-0.478f, 0.507f);
-            dB->speed = 0.021f;
-            dB->strenght = 1.282f;
-            dB->color = glm::vec3(0.485f, 0.485f, 0.485f);
-            dB->discard = glm::vec2(0.186f, 0.269f);
-            dB->inside = false;
-
-            dC->size = 4.599f;
-            dC->direction = glm::vec2(-1.0f, 1.0f);
-            dC->speed = 0.044f;
-            dC->strenght = 2.179f;
-            dC->color = glm::vec3(0.200f, 0.200f, 0.200f);
-            dC->discard = glm::vec2(0.071f, 0.353f);
-            dC->inside = false;
-
-            *cn = 35.749f;
-            *az = 34.596f;
-
-            *la = 0.115f;
-            *ld = 0.833f;
-            *ls = 0.756f;
-        }
+            applyConfig1(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+    }
+
+    static void applyConfig1(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
+        displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float *ls) {
+        *gr = 9.8f;
+        *wA = glm::vec4(-0.072f, 1.0f, 0.346f, 20.0f);
+        *wB = glm::vec4(0.855f, -0.536f, 0.417f, 12.814f);
+        *wC = glm::vec4(0.449f, 0.362f, 0.712f, 19.026f);
+
+        *wtClr = glm::vec3(0.279f, 0.528f, 1.0f);
+        *wtAm = glm::vec3(0.0f, 0.006f, 0.359f);
+        *wtDf = glm::vec3(0.05f, 0.165f, 0.65f);
+        *wtSp = glm::vec3(0.491f, 0.492f, 0.492f);
+        *wtSh = 67.0f;;
+
+        dA->size = 1.531f;
+        dA->direction = glm::vec2(1.0f);
+        dA->speed = 0.015f;
+        dA->strenght = 3.429f;
+        dA->color = glm::vec3(0.358f, 0.358f, 0.358f);
+        dA->discard = glm::vec2(0.269f, 0.333f);
+        dA->inside = true;
+
+        dB->size = 2.963f;
+        dB->direction = glm::vec2(-0.478f, 0.507f);
+        dB->speed = 0.021f;
+        dB->strenght = 1.282f;
+        dB->color = glm::vec3(0.485f, 0.485f, 0.485f);
+        dB->discard = glm::vec2(0.186f, 0.269f);
+        dB->inside = false;
+
+        dC->size = 4.599f;
+        dC->direction = glm::vec2(-1.0f, 1.0f);
+        dC->speed = 0.044f;
+        dC->strenght = 2.179f;
+        dC->color = glm::vec3(0.200f, 0.200f, 0.200f);
+        dC->discard = glm::vec2(0.071f, 0.353f);
+        dC->inside = false;
+
+        *cn = 35.749f;
+        *az = 34.596f;
+
+        *la = 0.115f;
+        *ld = 0.833f;
+        *ls = 0.756f;
     }
 
     void config2(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
         displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float* ls) {
         if (ImGui::Button("Configuration 2"))
-        {
-            *gr = 9.8f;
-            *wA = glm::vec4(-0.571f, 0.029f, 0.272f, 7.133f);
-            *wB = glm::vec4(0.086f, -0.229f, 0.259f, 8.215f);
-            *wC = glm::vec4(-0.114f, -0.057f, 0.418f, 5.329f);
-
-            *wtClr = glm::vec3(0.126f, 0.726f, 1.0f);;
-            *wtAm = glm::vec3(0.00f, 0.080f, 0.477f);
-            *wtDf = glm::vec3(0.0f, 0.584f, 0.846f);
-            *wtSp = glm::vec3(0.340f, 0.340f, 0.340f);
-            *wtSh = 100.0f;;;
-
-            dA->size = 1.0f;
-            dA->direction = glm::vec2(-1.0f, 1.0f);
-            dA->speed = 0.006f;
-            dA->strenght = 0.823f;
-            dA->color = glm::vec3(0.413f, 0.562f, 1.00f);
-            dA->discard = glm::vec2(0.139f, 0.333f);
-            dA->inside = true;
-
-            dB->size = 18.877f;
-            dB->direction = glm::vec2(0.629f, 0.507f);
-            dB->speed = 0.010f;
-            dB->strenght = 1.994f;
-            dB->color = glm::vec3(0.734f, 0.893f, 1.0f);
-            dB->discard = glm::vec2(0.025f, 0.196f);
-            dB->inside = true;
-
-            dC->size = 11.406f;
-            dC->direction = glm::vec2(-1.0f, -0.629f);
-            dC->speed = 0.018f;;
-            dC->strenght = 0.285f;
-            dC->color = glm::vec3(0.210f, 0.616f, 1.0f);
-            dC->discard = glm::vec2(0.1f, 0.259f);
-            dC->inside = false;
-
-            *cn = 53.515f;
-            *az = 9.109f;
-
-            *la = 0.115f;
-            *ld = 0.833f;
-            *ls = 0.756f;
-        }
+            applyConfig2(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+    }
+
+    static void applyConfig2(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
+        displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float* ls) {
+        *gr = 9.8f;
+        *wA = glm::vec4(-0.571f, 0.029f, 0.272f, 7.133f);
+        *wB = glm::vec4(0.086f, -0.229f, 0.259f, 8.215f);
+        *wC = glm::vec4(-0.114f, -0.057f, 0.418f, 5.329f);
+
+        *wtClr = glm::vec3(0.126f, 0.726f, 1.0f);;
+        *wtAm = glm::vec3(0.00f, 0.080f, 0.477f);
+        *wtDf = glm::vec3(0.0f, 0.584f, 0.846f);
+        *wtSp = glm::vec3(0.340f, 0.340f, 0.340f);
+        *wtSh = 100.0f;;;
+
+        dA->size = 1.0f;
+        dA->direction = glm::vec2(-1.0f, 1.0f);
+        dA->speed = 0.006f;
+        dA->strenght = 0.823f;
+        dA->color = glm::vec3(0.413f, 0.562f, 1.00f);
+        dA->discard = glm::vec2(0.139f, 0.333f);
+        dA->inside = true;
+
+        dB->size = 18.877f;
+        dB->direction = glm::vec2(0.629f, 0.507f);
+        dB->speed = 0.010f;
+        dB->strenght = 1.994f;
+        dB->color = glm::vec3(0.734f, 0.893f, 1.0f);
+        dB->discard = glm::vec2(0.025f, 0.196f);
+        dB->inside = true;
+
+        dC->size = 11.406f;
+        dC->direction = glm::vec2(-1.0f, -0.629f);
+        dC->speed = 0.018f;;
+        dC->strenght = 0.285f;
+        dC->color = glm::vec3(0.210f, 0.616f, 1.0f);
+        dC->discard = glm::vec2(0.1f, 0.259f);
+        dC->inside = false;
+
+        *cn = 53.515f;
+        *az = 9.109f;
+
+        *la = 0.115f;
+        *ld = 0.833f;
+        *ls = 0.756f;
     }
 
     void config3(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
         displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float* ls) {
         if (ImGui::Button("Configuration 3"))
-        {
-            *gr = 9.8f;
-            *wA = glm::vec4(1.0f, 1.0f, 0.5f, 10.0f);
-            *wB = glm::vec4(0.1f, 1.0f, 0.3f, 4.0f);
-            *wC = glm::vec4(0.4f, 0.2f, 0.7f, 2.0f);
-
-            *wtClr = glm::vec3(1.0f, 0.409f, 0.3f);
-            *wtAm = glm::vec3(0.049f, 0.049f, 0.628f);
-            *wtDf = glm::vec3(0.688f, 0.068f, 0.0f);
-            *wtSp = glm::vec3(1.0f, 0.612f, 0.00f);
-            *wtSh = 41.0f;
-
-            dA->size = 12.618f;
-            dA->direction = glm::vec2(1.0f);
-            dA->speed = 0.037f;
-            dA->strenght = 1.0f;
-            dA->color = glm::vec3(1.0f);
-            dA->discard = glm::vec2(0.19f, 0.5f);
-            dA->inside = true;
-
-            dB->size = 22.107f;
-            dB->direction = glm::vec2(-1.0f);
-            dB->speed = 0.011f;
-            dB->strenght = 1.930f;
-            dB->color = glm::vec3(1.0f);
-            dB->discard = glm::vec2(0.2f, 0.8f);
-            dB->inside = true;
-
-            dC->size = 6.359f;
-            dC->direction = glm::vec2(-0.686f, 0.429f);
-            dC->speed = 0.039f;
-            dC->strenght = 0.823f;
-            dC->color = glm::vec3(1.0f);
-            dC->discard = glm::vec2(0.165f, 0.392f);
-            dC->inside = false;
-
-            *cn = 79.703f;
-            *az = 0.80f;
-
-            *la = 0.310f;
-            *ld = 0.551f;
-            *ls = 0.842f;;
-        }
+            applyConfig3(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+    }
+
+    static void applyConfig3(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
+        displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float* ls) {
+        *gr = 9.8f;
+        *wA = glm::vec4(1.0f, 1.0f, 0.5f, 10.0f);
+        *wB = glm::vec4(0.1f, 1.0f, 0.3f, 4.0f);
+        *wC = glm::vec4(0.4f, 0.2f, 0.7f, 2.0f);
+
+        *wtClr = glm::vec3(1.0f, 0.409f, 0.3f);
+        *wtAm = glm::vec3(0.049f, 0.049f, 0.628f);
+        *wtDf = glm::vec3(0.688f, 0.068f, 0.0f);
+        *wtSp = glm::vec3(1.0f, 0.612f, 0.00f);
+        *wtSh = 41.0f;
+
+        dA->size = 12.618f;
+        dA->direction = glm::vec2(1.0f);
+        dA->speed = 0.037f;
+        dA->strenght = 1.0f;
+        dA->color = glm::vec3(1.0f);
+        dA->discard = glm::vec2(0.19f, 0.5f);
+        dA->inside = true;
+
+        dB->size = 22.107f;
+        dB->direction = glm::vec2(-1.0f);
+        dB->speed = 0.011f;
+        dB->strenght = 1.930f;
+        dB->color = glm::vec3(1.0f);
+        dB->discard = glm::vec2(0.2f, 0.8f);
+        dB->inside = true;
+
+        dC->size = 6.359f;
+        dC->direction = glm::vec2(-0.686f, 0.429f);
+        dC->speed = 0.039f;
+        dC->strenght = 0.823f;
+        dC->color = glm::vec3(1.0f);
+        dC->discard = glm::vec2(0.165f, 0.392f);
+        dC->inside = false;
+
+        *cn = 79.703f;
+        *az = 0.80f;
+
+        *la = 0.310f;
+        *ld = 0.551f;
+        *ls = 0.842f;;
     }
 
     void config4(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
         displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float* ls) {
         if (ImGui::Button("Configuration 4"))
-        {
-            *gr = 1.234;
-            *wA = glm::vec4(0.571f, -0.057f, 0.076f, 12.665f);
-            *wB = glm::vec4(-0.457f, -0.314f, 0.475f, 14.100f);
-            *wC = glm::vec4(-0.371f, 0.486f, 0.215f, 15.070f);
-
-            *wtClr = glm::vec3(1.0f, 0.199f, 0.0f);
-            *wtAm = glm::vec3(0.921f, 0.384f, 0.165f);
-            *wtDf = glm::vec3(0.813f, 0.375f, 0.137f);
-            *wtSp = glm::vec3(0.159f, 0.133f, 0.006f);
-            *wtSh = 100.0f;
-
-            dA->size = 2.523f;
-            dA->direction = glm::vec2(-1.0f, 1.0f);
-            dA->speed = 0.013f;
-            dA->strenght = 3.07f;
-            dA->color = glm::vec3(1.0f, 0.901f, 0.352f);
-            dA->discard = glm::vec2(0.025f, 0.259f);
-            dA->inside = true;
-
-            dB->size = 4.946f;
-            dB->direction = glm::vec2(-0.514f, 0.371f);
-            dB->speed = 0.013f;
-            dB->strenght = 1.962f;
-            dB->color = glm::vec3(1.0f, 0.839f, 0.00f);
-            dB->discard = glm::vec2(0.057f, 0.589f);
-            dB->inside = true;
-
-            dC->size = 3.532f;
-            dC->direction = glm::vec2(-0.171f, 0.4f);
-            dC->speed = 0.014f;
-            dC->strenght = 2.722f;
-            dC->color = glm::vec3(1.0f, 0.563f, 0.00f);
-            dC->discard = glm::vec2(0.247f, 0.576f);
-            dC->inside = false;
-
-            *cn = 53.515f;
-            *az = 9.189f;
-
-            *la = 0.115f;
-            *ld = 0.833f;
-            *ls = 0.756f;
+            applyConfig4(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+    }
+
+    static void applyConfig4(float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
+        displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float* ls) {
+        *gr = 1.234;
+        *wA = glm::vec4(0.571f, -0.057f, 0.076f, 12.665f);
+        *wB = glm::vec4(-0.457f, -0.314f, 0.475f, 14.100f);
+        *wC = glm::vec4(-0.371f, 0.486f, 0.215f, 15.070f);
+
+        *wtClr = glm::vec3(1.0f, 0.199f, 0.0f);
+        *wtAm = glm::vec3(0.921f, 0.384f, 0.165f);
+        *wtDf = glm::vec3(0.813f, 0.375f, 0.137f);
+        *wtSp = glm::vec3(0.159f, 0.133f, 0.006f);
+        *wtSh = 100.0f;
+
+        dA->size = 2.523f;
+        dA->direction = glm::vec2(-1.0f, 1.0f);
+        dA->speed = 0.013f;
+        dA->strenght = 3.07f;
+        dA->color = glm::vec3(1.0f, 0.901f, 0.352f);
+        dA->discard = glm::vec2(0.025f, 0.259f);
+        dA->inside = true;
+
+        dB->size = 4.946f;
+        dB->direction = glm::vec2(-0.514f, 0.371f);
+        dB->speed = 0.013f;
+        dB->strenght = 1.962f;
+        dB->color = glm::vec3(1.0f, 0.839f, 0.00f);
+        dB->discard = glm::vec2(0.057f, 0.589f);
+        dB->inside = true;
+
+        dC->size = 3.532f;
+        dC->direction = glm::vec2(-0.171f, 0.4f);
+        dC->speed = 0.014f;
+        dC->strenght = 2.722f;
+        dC->color = glm::vec3(1.0f, 0.563f, 0.00f);
+        dC->discard = glm::vec2(0.247f, 0.576f);
+        dC->inside = false;
+
+        *cn = 53.515f;
+        *az = 9.189f;
+
+        *la = 0.115f;
+        *ld = 0.833f;
+        *ls = 0.756f;
+    }
+
+    // sets the scene parameters of preset 1 to 4, as its "Configuration" button does
+    static void applyConfig(unsigned int preset, float* gr, glm::vec4* wA, glm::vec4* wB, glm::vec4* wC, glm::vec3* wtClr, glm::vec3* wtAm, glm::vec3* wtDf, glm::vec3* wtSp, float* wtSh,
+        displace* dA, displace* dB, displace* dC, float* cn, float* az, float* la, float* ld, float* ls) {
+        switch (preset) {
+        case 1:
+            applyConfig1(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+            break;
+        case 2:
+            applyConfig2(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+            break;
+        case 3:
+            applyConfig3(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+            break;
+        case 4:
+            applyConfig4(gr, wA, wB, wC, wtClr, wtAm, wtDf, wtSp, wtSh, dA, dB, dC, cn, az, la, ld, ls);
+            break;
+        default:
+            break;
         }
     }
 
@@ -541,4 +764,16 @@ public:
         ImGui::DestroyContext();
     }
 
+private:
+    bool profilerLive = true;
+    int64_t profilerFrameStart = 0;
+    float profilerPanelMs = 0.0f;
+
+    void drawTimeBar(const char* name, float ms, float totalMs) {
+        char label[32];
+        snprintf(label, sizeof(label), "%.3f ms", ms);
+        ImGui::ProgressBar(totalMs > 0.0f ? ms / totalMs : 0.0f, ImVec2(ImGui::GetContentRegionAvail().x * 0.6f, 0.0f), label);
+        ImGui::SameLine();
+        ImGui::TextUnformatted(name);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,131 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "../util/renderStats.h"
+#include "../util/programCache.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+
+// A program with a single compute stage (GL 4.3). Built like Shader, through the program cache and
+// with the same kind of defines, but always right away: the compute passes are few and small.
+class ComputeShader
+{
+public:
+    unsigned int ID;
+    ComputeShader(const char* computePath, const std::string& defines = "") :
+        ID(0)
+    {
+        PROFILE_SCOPE("ComputeShader::ComputeShader");
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = cShaderStream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::COMPUTE_SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        }
+        ProgramCache& cache = ProgramCache::instance();
+        ProgramKey key = cache.key(computePath, "", computeCode, "", defines);
+        ID = cache.load(key);
+        if (ID == 0)
+        {
+            std::string code = Shader::injectDefines(computeCode, defines);
+            const char* cShaderCode = code.c_str();
+            unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+            glShaderSource(compute, 1, &cShaderCode, NULL);
+            glCompileShader(compute);
+            checkCompileErrors(compute, "COMPUTE");
+            ID = glCreateProgram();
+            glAttachShader(ID, compute);
+            cache.prepare(ID);
+            glLinkProgram(ID);
+            checkCompileErrors(ID, "PROGRAM");
+            glDeleteShader(compute);
+            cache.store(key, ID);
+        }
+        cache.addBuildTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    ~ComputeShader()
+    {
+        glDeleteProgram(ID);
+    }
+    ComputeShader(const ComputeShader&) = delete;
+    ComputeShader& operator=(const ComputeShader&) = delete;
+    // activate the shader
+    // ------------------------------------------------------------------------
+    void use() const
+    {
+        glUseProgram(ID);
+    }
+    // runs groupsX * groupsY work groups, the program must be in use
+    void dispatch(unsigned int groupsX, unsigned int groupsY) const
+    {
+        glDispatchCompute(groupsX, groupsY, 1);
+    }
+    // utility uniform functions
+    // ------------------------------------------------------------------------
+    void setInt(const char* name, int value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform1i(glGetUniformLocation(ID, name), value);
+    }
+    void setFloat(const char* name, float value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform1f(glGetUniformLocation(ID, name), value);
+    }
+    void setVec2(const char* name, const glm::vec2& value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform2fv(glGetUniformLocation(ID, name), 1, &value[0]);
+    }
+    void setVec4Array(const char* name, const glm::vec4* values, unsigned int count) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform4fv(glGetUniformLocation(ID, name), (GLsizei)count, &values[0][0]);
+    }
+
+private:
+    // utility function for checking shader compilation/linking errors.
+    // ------------------------------------------------------------------------
+    void checkCompileErrors(GLuint shader, std::string type)
+    {
+        GLint success;
+        GLchar infoLog[1024];
+        if (type != "PROGRAM")
+        {
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+        else
+        {
+            glGetProgramiv(shader, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+    }
+};
+#endif
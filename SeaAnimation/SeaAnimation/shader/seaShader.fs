@@ -1,6 +1,45 @@
 #version 330 core
+#define M_PI 3.1415926535897932384626433832795
+// the detail waves evaluated are counted for --filter-benchmark, before any declaration for the extension
+#ifndef COUNT_WAVES
+#define COUNT_WAVES 0
+#endif
+#ifndef DETAIL_WAVES
+#define DETAIL_WAVES 0
+#endif
+#if COUNT_WAVES && DETAIL_WAVES
+#extension GL_ARB_shader_atomic_counters : require
+layout (binding = 0, offset = 8) uniform atomic_uint fragmentsShaded;
+layout (binding = 0, offset = 12) uniform atomic_uint detailWavesEvaluated;
+#endif
 out vec4 FragColor;
 
+// Noise layers are compile time switches (see seaPermutation in main.cpp): a layer that is off costs
+// no texture reads, and whether a layer keeps the inside or the outside of its range is a constant.
+#ifndef DIS_A
+#define DIS_A 1
+#define DIS_A_INSIDE 1
+#endif
+#ifndef DIS_B
+#define DIS_B 1
+#define DIS_B_INSIDE 0
+#endif
+#ifndef DIS_C
+#define DIS_C 1
+#define DIS_C_INSIDE 0
+#endif
+#ifndef SEA_BAKED
+#define SEA_BAKED 0
+#endif
+// the DETAIL_WAVES after the first WAVE_COUNT of seaShader.vs only bend the normal, evaluated here
+#ifndef WAVE_COUNT
+#define WAVE_COUNT 3
+#endif
+// the detail waves too short for the fragment's distance are left out, see seaShader.vs
+#ifndef WAVE_FILTER
+#define WAVE_FILTER 0
+#endif
+
 struct Material {
     vec3 color;
     vec3 ambient;
@@ -18,7 +57,25 @@ struct Light {
 };
 
 in vec3 FragPos;  
+#if SEA_BAKED
+in vec2 BakeCoords;
+#elif DETAIL_WAVES
+in vec2 GridPos;
+in vec3 Tangent;
+in vec3 Binormal;
+#endif
+#if SEA_BAKED || DETAIL_WAVES
+uniform mat3 normalMatrix;
+#endif
+#if SEA_BAKED == 2
+uniform sampler2DArray normalMap;
+uniform float loopFrame;
+uniform float loopFrames;
+#elif SEA_BAKED
+uniform sampler2D normalMap;
+#elif !DETAIL_WAVES
 in vec3 Normal;  
+#endif
 in vec2 TexCoords;
 
 uniform sampler2D texture_tmp;
@@ -35,7 +92,7 @@ uniform float disASpeed;
 uniform float disAStrenght;
 uniform vec3 disAColor;
 uniform vec2 disADiscard;
-uniform bool disAInside;
+const bool disAInside = DIS_A_INSIDE != 0;
 
 uniform float disBSize;
 uniform vec2 disBDir;
@@ -43,7 +100,7 @@ uniform float disBSpeed;
 uniform float disBStrenght;
 uniform vec3 disBColor;
 uniform vec2 disBDiscard;
-uniform bool disBInside;
+const bool disBInside = DIS_B_INSIDE != 0;
 
 uniform float disCSize;
 uniform vec2 disCDir;
@@ -51,7 +108,47 @@ uniform float disCSpeed;
 uniform float disCStrenght;
 uniform vec3 disCColor;
 uniform vec2 disCDiscard;
-uniform bool disCInside;
+const bool disCInside = DIS_C_INSIDE != 0;
+
+#if SEA_BAKED
+vec3 bakedNormal(vec2 coords)
+{
+#if SEA_BAKED == 2
+    // the looped frames in between are blended, see seaShader.vs
+    float frame = floor(loopFrame);
+    vec3 current = texture(normalMap, vec3(coords, frame)).xyz;
+    vec3 next = texture(normalMap, vec3(coords, mod(frame + 1.0f, loopFrames))).xyz;
+    return mix(current, next, loopFrame - frame);
+#else
+    return texture(normalMap, coords).xyz;
+#endif
+}
+#endif
+
+#if DETAIL_WAVES
+uniform float gravity;
+uniform vec4 waveA;
+uniform vec4 waveB;
+uniform vec4 waveC;
+#if WAVE_FILTER
+uniform float pixelCutoff;
+#endif
+
+// the tangent and binormal terms of GerstnerWave in seaShader.vs, without the displacement
+void detailWave(vec4 wave, vec2 p, inout vec3 tangent, inout vec3 binormal)
+{
+    float steepness = wave.z;
+    float k = 2 * M_PI / wave.w;
+    float c = sqrt(gravity / k);
+    vec2 d = normalize(wave.xy);
+    float f = k * (dot(d, p) - c * time);
+    float s = steepness * sin(f);
+    float h = steepness * cos(f);
+
+    tangent += vec3(1 - d.x * d.x * s, -d.x * d.y * s, d.x * h);
+    binormal += vec3(-d.x * d.y * s, 1 - d.y * d.y * s, d.y * h);
+}
+#endif
 
 vec2 getDistortion(vec2 tx_coords, float speed, float unit)
 {
@@ -67,9 +164,9 @@ vec2 getDistortion(vec2 tx_coords, float speed, float unit)
     return vec2(fx, fy);
 }
 
-vec3 getNoise(sampler2D tx_sampler, vec2 direction, float speed, float strenght, float size, vec3 color, vec2 discrd, bool inside)
+vec3 getNoise(sampler2D tx_sampler, vec2 distorted, vec2 direction, float speed, float strenght, float size, vec3 color, vec2 discrd, bool inside)
 {
-    vec2 coords = getDistortion(TexCoords, 0.04f, 0.005f);
+    vec2 coords = distorted;
     vec2 nDir = normalize(direction);
     coords += nDir * speed * time;
     vec4 tx_color = texture(tx_sampler, coords * size);
@@ -100,7 +197,45 @@ void main()
     vec3 ambient = light.ambient * material.ambient;
   	
     // diffuse 
+#if SEA_BAKED
+    vec3 norm = normalize(normalMatrix * bakedNormal(BakeCoords));
+#elif DETAIL_WAVES
+    vec3 tangent = Tangent;
+    vec3 binormal = Binormal;
+#if WAVE_FILTER
+    float cutoff = pixelCutoff * distance(viewPos, FragPos);
+    vec4 waves[3] = vec4[3](waveA, waveB, waveC);
+    int evaluated = WAVE_COUNT;
+    for (; evaluated < WAVE_COUNT + DETAIL_WAVES; evaluated++)
+    {
+        float weight = clamp(waves[evaluated].w / cutoff - 1.0f, 0.0f, 1.0f);
+        if (weight == 0.0f)
+            break;
+        detailWave(vec4(waves[evaluated].xy, waves[evaluated].z * weight, waves[evaluated].w), GridPos, tangent, binormal);
+    }
+    tangent.x += float(WAVE_COUNT + DETAIL_WAVES - evaluated);
+    binormal.y += float(WAVE_COUNT + DETAIL_WAVES - evaluated);
+#else
+    int evaluated = WAVE_COUNT + DETAIL_WAVES;
+#if WAVE_COUNT < 1
+    detailWave(waveA, GridPos, tangent, binormal);
+#endif
+#if WAVE_COUNT < 2 && WAVE_COUNT + DETAIL_WAVES > 1
+    detailWave(waveB, GridPos, tangent, binormal);
+#endif
+#if WAVE_COUNT + DETAIL_WAVES > 2
+    detailWave(waveC, GridPos, tangent, binormal);
+#endif
+#endif
+#if COUNT_WAVES
+    atomicCounterIncrement(fragmentsShaded);
+    for (int i = WAVE_COUNT; i < evaluated; i++)
+        atomicCounterIncrement(detailWavesEvaluated);
+#endif
+    vec3 norm = normalize(normalMatrix * cross(tangent, binormal));
+#else
     vec3 norm = normalize(Normal);
+#endif
     //vec3 lightDir = normalize(light.position - FragPos);
     vec3 lightDir = normalize(-light.direction); 
     float diff = max(dot(norm, lightDir), 0.0);
@@ -114,8 +249,19 @@ void main()
         
     vec3 result = ambient + diffuse + specular;
     vec3 newColor = material.color;
-    newColor += getNoise(texture_tmp, disADir, disASpeed, disAStrenght, disASize, disAColor, disADiscard, disAInside);
-    newColor += getNoise(texture_tmp, disBDir, disBSpeed, disBStrenght, disBSize, disBColor, disBDiscard, disBInside);
-    newColor = result * newColor + getDistortedNoise(disCDir, disCSpeed, disCStrenght, disCSize, disCColor, disCDiscard, disCInside);
+#if DIS_A || DIS_B
+    // both layers start from the same distorted coordinates
+    vec2 distorted = getDistortion(TexCoords, 0.04f, 0.005f);
+#endif
+#if DIS_A
+    newColor += getNoise(texture_tmp, distorted, disADir, disASpeed, disAStrenght, disASize, disAColor, disADiscard, disAInside);
+#endif
+#if DIS_B
+    newColor += getNoise(texture_tmp, distorted, disBDir, disBSpeed, disBStrenght, disBSize, disBColor, disBDiscard, disBInside);
+#endif
+    newColor = result * newColor;
+#if DIS_C
+    newColor += getDistortedNoise(disCDir, disCSpeed, disCStrenght, disCSize, disCColor, disCDiscard, disCInside);
+#endif
     FragColor = vec4(newColor, 1.0) ;
 } 
\ No newline at end of file
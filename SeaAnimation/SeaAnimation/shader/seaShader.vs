@@ -1,11 +1,48 @@
 #version 330 core
 #define M_PI 3.1415926535897932384626433832795
 
+// how many of waveA, waveB, waveC are evaluated, the others are flat (see seaPermutation in main.cpp)
+#ifndef WAVE_COUNT
+#define WAVE_COUNT 3
+#endif
+// the waves come from textures instead: 1 the bake of this frame (seaBake.comp, SeaWaveBake), 2 the
+// frames of a looped animation baked on load (SeaLoop), blended between the two around loopFrame
+#ifndef SEA_BAKED
+#define SEA_BAKED 0
+#endif
+// how many waves after the first WAVE_COUNT only bend the normal, per fragment in seaShader.fs: waves
+// too short for the grid to follow, which then can be much coarser (see seaPermutation in main.cpp)
+#ifndef DETAIL_WAVES
+#define DETAIL_WAVES 0
+#endif
+// waves too short for the vertex's distance or the mesh's spacing are left out (SeaWaveFilter), the
+// waves come sorted longest first; COUNT_WAVES counts the ones evaluated, for --filter-benchmark
+#ifndef WAVE_FILTER
+#define WAVE_FILTER 0
+#endif
+#ifndef COUNT_WAVES
+#define COUNT_WAVES 0
+#endif
+#if COUNT_WAVES
+#extension GL_ARB_shader_atomic_counters : require
+layout (binding = 0, offset = 0) uniform atomic_uint verticesShaded;
+layout (binding = 0, offset = 4) uniform atomic_uint wavesEvaluated;
+#endif
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoords;
 
 out vec3 FragPos;
+#if SEA_BAKED
+out vec2 BakeCoords;
+#elif DETAIL_WAVES
+// the surface before the detail waves, which seaShader.fs adds to at GridPos
+out vec2 GridPos;
+out vec3 Tangent;
+out vec3 Binormal;
+#else
 out vec3 Normal;
+#endif
 out vec2 TexCoords;
 
 uniform mat4 model;
@@ -19,6 +56,46 @@ uniform vec4 waveA;
 uniform vec4 waveB;
 uniform vec4 waveC;
 
+#if WAVE_FILTER
+uniform vec3 viewPos;
+uniform float pixelCutoff;
+uniform float samplesPerWave;
+uniform float vertexSpacing;
+#endif
+
+#if SEA_BAKED == 2
+uniform sampler2DArray displacementMap;
+uniform float loopFrame;
+uniform float loopFrames;
+#elif SEA_BAKED
+uniform sampler2D displacementMap;
+#endif
+
+#if SEA_BAKED
+uniform vec2 bakeOrigin;
+uniform vec2 bakeExtent;
+uniform float bakeResolution;
+
+// texel i of the bake holds grid point i, at the centre of the texel
+vec2 bakeCoords(vec2 xy)
+{
+    vec2 t = (xy - bakeOrigin) / bakeExtent;
+    return (t * (bakeResolution - 1.0f) + 0.5f) / bakeResolution;
+}
+
+vec3 bakedDisplacement(vec2 coords)
+{
+#if SEA_BAKED == 2
+    float frame = floor(loopFrame);
+    vec3 current = textureLod(displacementMap, vec3(coords, frame), 0.0f).xyz;
+    vec3 next = textureLod(displacementMap, vec3(coords, mod(frame + 1.0f, loopFrames)), 0.0f).xyz;
+    return mix(current, next, loopFrame - frame);
+#else
+    return textureLod(displacementMap, coords, 0.0f).xyz;
+#endif
+}
+#endif
+
 vec3 GerstnerWave(vec4 wave, vec3 p, inout vec3 tangent, inout vec3 binormal)
 {
     float steepness = wave.z;
@@ -48,17 +125,58 @@ vec3 GerstnerWave(vec4 wave, vec3 p, inout vec3 tangent, inout vec3 binormal)
 
 void main()
 {   
+#if SEA_BAKED
+    // the normal is fetched per fragment
+    BakeCoords = bakeCoords(aPos.xy);
+    vec3 p = aPos + bakedDisplacement(BakeCoords);
+#else
     vec3 point = aPos;
-    vec3 tangent = vec3(0.0f, 0.0f, 0.0f);
-    vec3 binormal = vec3(0.0f, 0.0f, 0.0f);
+    // a flat wave only adds (1, 0, 0) to the tangent and (0, 1, 0) to the binormal
+    vec3 tangent = vec3(3 - WAVE_COUNT - DETAIL_WAVES, 0.0f, 0.0f);
+    vec3 binormal = vec3(0.0f, 3 - WAVE_COUNT - DETAIL_WAVES, 0.0f);
     vec3 p = point;
+#if WAVE_FILTER
+    // the waves shorter than cutoff are left out, sorted as they are the first one ends the loop
+    float cutoff = max(pixelCutoff * distance(viewPos, vec3(model * vec4(point, 1.0))), samplesPerWave * vertexSpacing);
+    vec4 waves[3] = vec4[3](waveA, waveB, waveC);
+    int evaluated = 0;
+    for (; evaluated < WAVE_COUNT; evaluated++)
+    {
+        float weight = clamp(waves[evaluated].w / cutoff - 1.0f, 0.0f, 1.0f);
+        if (weight == 0.0f)
+            break;
+        p += GerstnerWave(vec4(waves[evaluated].xy, waves[evaluated].z * weight, waves[evaluated].w), point, tangent, binormal);
+    }
+    tangent.x += float(WAVE_COUNT - evaluated);
+    binormal.y += float(WAVE_COUNT - evaluated);
+#else
+    int evaluated = WAVE_COUNT;
+#if WAVE_COUNT > 0
     p += GerstnerWave(waveA, point, tangent, binormal);
+#endif
+#if WAVE_COUNT > 1
     p += GerstnerWave(waveB, point, tangent, binormal);
+#endif
+#if WAVE_COUNT > 2
     p += GerstnerWave(waveC, point, tangent, binormal);
+#endif
+#endif
+#if COUNT_WAVES
+    atomicCounterIncrement(verticesShaded);
+    for (int i = 0; i < evaluated; i++)
+        atomicCounterIncrement(wavesEvaluated);
+#endif
+#if DETAIL_WAVES
+    GridPos = point.xy;
+    Tangent = tangent;
+    Binormal = binormal;
+#else
     vec3 aNormal = normalize(cross(tangent, binormal));
+    Normal = mat3(transpose(inverse(model))) * aNormal; 
+#endif
+#endif
 
     FragPos = vec3(model * vec4(p, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal; 
     TexCoords = aTexCoords;    
     gl_Position = projection * view * model * vec4(p, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 410 core
+
+// corners of the sea patches, displaced after tessellation (seaTess.tes)
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+
+out vec3 ControlPos;
+out vec2 ControlTexCoords;
+
+void main()
+{
+    ControlPos = aPos;
+    ControlTexCoords = aTexCoords;
+}
@@ -4,19 +4,46 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "../util/profiler.h"
+#include "../util/renderStats.h"
+#include "../util/programCache.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <chrono>
 
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly, or loads it from the program cache when it was
+    // built from the same sources before. defines are lines like "#define NAME 1\n" put after the
+    // #version line of every stage. A deferred shader only submits its compile and link: it is pending
+    // until finish() (ShaderManager calls it once the driver is done), and mustn't be used before.
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "", bool deferred = false) :
+        Shader(vertexPath, NULL, NULL, fragmentPath, defines, deferred)
+    {}
+    // the same with tessellation control and evaluation stages, drawn as GL_PATCHES
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
+    Shader(const char* vertexPath, const char* controlPath, const char* evaluationPath, const char* fragmentPath, const std::string& defines = "", bool deferred = false) :
+        ID(0),
+        vertexFile(vertexPath),
+        controlFile(controlPath ? controlPath : ""),
+        evaluationFile(evaluationPath ? evaluationPath : ""),
+        fragmentFile(fragmentPath),
+        programDefines(defines),
+        pending(false),
+        vertex(0),
+        control(0),
+        evaluation(0),
+        fragment(0),
+        submitMs(0.0)
     {
+        PROFILE_SCOPE("Shader::Shader");
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -45,30 +72,92 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
+        std::string controlCode, evaluationCode;
+        if (hasTessellation() && (!readStage(controlFile, controlCode) || !readStage(evaluationFile, evaluationCode)))
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << controlFile << " " << evaluationFile << std::endl;
+        ProgramCache& cache = ProgramCache::instance();
+        // the tessellation stages are hashed along with the vertex stage, and their paths with the defines
+        ProgramKey key = cache.key(vertexPath, fragmentPath, vertexCode + controlCode + evaluationCode, fragmentCode, controlFile + evaluationFile + defines);
+        ID = cache.load(key);
+        if (ID == 0)
+            submit(injectDefines(vertexCode, defines), injectDefines(controlCode, defines), injectDefines(evaluationCode, defines), injectDefines(fragmentCode, defines), key);
+        submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!deferred)
+            finish();
+        else if (!pending)
+            cache.addBuildTime(submitMs);
+    }
+    // what the program is built from, for rebuilding it (ShaderHotReload)
+    const std::string& getVertexPath() const
+    {
+        return vertexFile;
+    }
+    const std::string& getFragmentPath() const
+    {
+        return fragmentFile;
+    }
+    // empty without tessellation stages
+    const std::string& getControlPath() const
+    {
+        return controlFile;
+    }
+    const std::string& getEvaluationPath() const
+    {
+        return evaluationFile;
+    }
+    bool hasTessellation() const
+    {
+        return !controlFile.empty();
+    }
+    const std::string& getDefines() const
+    {
+        return programDefines;
+    }
+    // true while a deferred compile and link hasn't been finished
+    bool isPending() const
+    {
+        return pending;
+    }
+    // checks the compile and link results, deletes the shader objects and caches the program; waits
+    // for the driver if it is still compiling
+    void finish()
+    {
+        if (!pending)
+            return;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
         checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
+        if (hasTessellation())
+        {
+            checkCompileErrors(control, "TESS_CONTROL");
+            checkCompileErrors(evaluation, "TESS_EVALUATION");
+        }
         checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
+        if (hasTessellation())
+        {
+            glDeleteShader(control);
+            glDeleteShader(evaluation);
+        }
         glDeleteShader(fragment);
-
+        ProgramCache::instance().store(pendingKey, ID);
+        pending = false;
+        ProgramCache::instance().addBuildTime(submitMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    // #version has to stay the first line, the defines go right after it
+    // ------------------------------------------------------------------------
+    static std::string injectDefines(const std::string& code, const std::string& defines)
+    {
+        if (defines.empty())
+            return code;
+        size_t version = code.find("#version");
+        if (version == std::string::npos)
+            return defines + code;
+        size_t lineEnd = code.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return code + "\n" + defines;
+        return code.substr(0, lineEnd + 1) + defines + code.substr(lineEnd + 1);
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -78,68 +167,194 @@ public:
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
+    void setBool(const char* name, bool value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform1i(glGetUniformLocation(ID, name), (int)value);
+    }
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        setBool(name.c_str(), value);
     }
     // ------------------------------------------------------------------------
+    void setInt(const char* name, int value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform1i(glGetUniformLocation(ID, name), value);
+    }
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        setInt(name.c_str(), value);
     }
     // ------------------------------------------------------------------------
+    void setFloat(const char* name, float value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform1f(glGetUniformLocation(ID, name), value);
+    }
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        setFloat(name.c_str(), value);
     }
     // ------------------------------------------------------------------------
+    void setVec2(const char* name, const glm::vec2& value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform2fv(glGetUniformLocation(ID, name), 1, &value[0]);
+    }
     void setVec2(const std::string& name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec2(name.c_str(), value);
+    }
+    void setVec2(const char* name, float x, float y) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform2f(glGetUniformLocation(ID, name), x, y);
     }
     void setVec2(const std::string& name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        setVec2(name.c_str(), x, y);
     }
     // ------------------------------------------------------------------------
+    void setVec3(const char* name, const glm::vec3& value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform3fv(glGetUniformLocation(ID, name), 1, &value[0]);
+    }
     void setVec3(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec3(name.c_str(), value);
+    }
+    void setVec3(const char* name, float x, float y, float z) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform3f(glGetUniformLocation(ID, name), x, y, z);
     }
     void setVec3(const std::string& name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        setVec3(name.c_str(), x, y, z);
     }
     // ------------------------------------------------------------------------
+    void setVec4(const char* name, const glm::vec4& value) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform4fv(glGetUniformLocation(ID, name), 1, &value[0]);
+    }
     void setVec4(const std::string& name, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec4(name.c_str(), value);
+    }
+    void setVec4(const char* name, float x, float y, float z, float w) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniform4f(glGetUniformLocation(ID, name), x, y, z, w);
     }
     void setVec4(const std::string& name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        setVec4(name.c_str(), x, y, z, w);
     }
     // ------------------------------------------------------------------------
+    void setMat2(const char* name, const glm::mat2& mat) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniformMatrix2fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
+    }
     void setMat2(const std::string& name, const glm::mat2& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(name.c_str(), mat);
     }
     // ------------------------------------------------------------------------
+    void setMat3(const char* name, const glm::mat3& mat) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniformMatrix3fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
+    }
     void setMat3(const std::string& name, const glm::mat3& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(name.c_str(), mat);
     }
     // ------------------------------------------------------------------------
+    void setMat4(const char* name, const glm::mat4& mat) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
+    }
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(name.c_str(), mat);
+    }
+    void setMat4T(const char* name, const glm::mat4& mat) const
+    {
+        RenderStats::instance().uniformUpload();
+        glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_TRUE, &mat[0][0]);
     }
     void setMat4T(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_TRUE, &mat[0][0]);
+        setMat4T(name.c_str(), mat);
     }
 
 private:
+    std::string vertexFile;
+    std::string controlFile;
+    std::string evaluationFile;
+    std::string fragmentFile;
+    std::string programDefines;
+    bool pending;
+    unsigned int vertex, control, evaluation, fragment;
+    ProgramKey pendingKey;
+    double submitMs;
+
+    // issues the compiles and the link without asking for their results, which would wait for them
+    // ------------------------------------------------------------------------
+    void submit(const std::string& vertexCode, const std::string& controlCode, const std::string& evaluationCode, const std::string& fragmentCode, const ProgramKey& key)
+    {
+        const char* vShaderCode = vertexCode.c_str();
+        const char* fShaderCode = fragmentCode.c_str();
+        // 2. compile shaders
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        // tessellation shaders
+        if (hasTessellation())
+        {
+            const char* tcShaderCode = controlCode.c_str();
+            const char* teShaderCode = evaluationCode.c_str();
+            control = glCreateShader(GL_TESS_CONTROL_SHADER);
+            glShaderSource(control, 1, &tcShaderCode, NULL);
+            glCompileShader(control);
+            evaluation = glCreateShader(GL_TESS_EVALUATION_SHADER);
+            glShaderSource(evaluation, 1, &teShaderCode, NULL);
+            glCompileShader(evaluation);
+        }
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glCompileShader(fragment);
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        if (hasTessellation())
+        {
+            glAttachShader(ID, control);
+            glAttachShader(ID, evaluation);
+        }
+        glAttachShader(ID, fragment);
+        ProgramCache::instance().prepare(ID);
+        glLinkProgram(ID);
+        pendingKey = key;
+        pending = true;
+    }
+    static bool readStage(const std::string& path, std::string& code)
+    {
+        std::ifstream file(path.c_str());
+        if (!file)
+            return false;
+        std::stringstream stream;
+        stream << file.rdbuf();
+        code = stream.str();
+        return true;
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -4,6 +4,11 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
+// compressed vertex layout (see util/vertexPacking.h)
+layout (location = 5) in vec3 aPackedPos;
+layout (location = 6) in vec2 aOctNormal;
+layout (location = 7) in vec4 aTangentFrame;
+layout (location = 8) in vec2 aPackedTexCoords;
 
 out VS_OUT {
     vec3 FragPos;
@@ -20,14 +25,48 @@ uniform mat4 model;
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 
+uniform bool packedVertices;
+uniform vec3 posOffset;
+uniform vec3 posScale;
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+// first column of the rotation matrix of q, i.e. q * (1, 0, 0) * q^-1
+vec3 quatTangent(vec4 q)
+{
+    return vec3(
+        1.0 - 2.0 * (q.y * q.y + q.z * q.z),
+        2.0 * (q.x * q.y + q.w * q.z),
+        2.0 * (q.x * q.z - q.w * q.y)
+    );
+}
+
 void main()
 {
-    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));   
-    vs_out.TexCoords = aTexCoords;
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+    vec3 tangent = aTangent;
+    vec2 texCoords = aTexCoords;
+    if (packedVertices)
+    {
+        position = posOffset + aPackedPos * posScale;
+        normal = decodeOctahedral(aOctNormal);
+        tangent = quatTangent(aTangentFrame);
+        texCoords = aPackedTexCoords;
+    }
+
+    vs_out.FragPos = vec3(model * vec4(position, 1.0));   
+    vs_out.TexCoords = texCoords;
     
     mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 N = normalize(normalMatrix * aNormal);
+    vec3 T = normalize(normalMatrix * tangent);
+    vec3 N = normalize(normalMatrix * normal);
     T = normalize(T - dot(T, N) * N);
     vec3 B = cross(N, T);
     
@@ -36,5 +75,5 @@ void main()
     vs_out.TangentViewPos  = TBN * viewPos;
     vs_out.TangentFragPos  = TBN * vs_out.FragPos;
         
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(position, 1.0);
 }
\ No newline at end of file
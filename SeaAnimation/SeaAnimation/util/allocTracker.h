@@ -0,0 +1,90 @@
+#pragma once
+
+#include <new>
+#include <stdint.h>
+#include <stdlib.h>
+
+// heap traffic of one thread through operator new / delete
+struct AllocCounters {
+	uint64_t allocations;
+	uint64_t frees;
+	uint64_t bytes;
+};
+
+// Per thread allocation counters. They are fed by replacement global operators new and delete, which
+// are defined in the one translation unit that includes this header after defining
+// ALLOC_TRACKER_IMPLEMENTATION; without it every counter stays at zero. Only C++ allocations are
+// seen: ImGui, GLFW and the driver allocate with malloc.
+class AllocTracker
+{
+public:
+	// counters of the calling thread
+	static inline AllocCounters& thread()
+	{
+		static thread_local AllocCounters counters = { 0, 0, 0 };
+		return counters;
+	}
+
+	static inline uint64_t threadAllocations()
+	{
+		return thread().allocations;
+	}
+};
+
+// allocations made by the calling thread between consecutive beginFrame calls
+class FrameAllocations
+{
+public:
+	FrameAllocations() :
+		start(AllocTracker::threadAllocations()),
+		last(0)
+	{}
+
+	void beginFrame()
+	{
+		uint64_t now = AllocTracker::threadAllocations();
+		last = (unsigned int)(now - start);
+		start = now;
+	}
+
+	inline unsigned int getLastFrame() const
+	{
+		return last;
+	}
+
+private:
+	uint64_t start;
+	unsigned int last;
+};
+
+#ifdef ALLOC_TRACKER_IMPLEMENTATION
+// the nothrow and sized forms forward to these
+void* operator new(size_t size)
+{
+	AllocCounters& counters = AllocTracker::thread();
+	counters.allocations++;
+	counters.bytes += size;
+	void* p = malloc(size > 0 ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	if (!p)
+		return;
+	AllocTracker::thread().frees++;
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	operator delete(p);
+}
+#endif
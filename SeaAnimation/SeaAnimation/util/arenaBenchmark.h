@@ -0,0 +1,117 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frameArena.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <stdio.h>
+
+// One frame of the transient work the arena is meant for: a culling list grown one entry at a time,
+// instance matrices, a sorted draw list and some UI text, all built with allocators made by alloc.
+template <typename MakeAllocator>
+unsigned int transientFrameWork(unsigned int frame, unsigned int objects, const MakeAllocator& alloc)
+{
+	typedef typename MakeAllocator::template Of<unsigned int>::type IndexAllocator;
+	typedef typename MakeAllocator::template Of<glm::mat4>::type MatrixAllocator;
+	typedef typename MakeAllocator::template Of<unsigned long long>::type KeyAllocator;
+	typedef typename MakeAllocator::template Of<char>::type CharAllocator;
+
+	std::vector<unsigned int, IndexAllocator> visible(alloc.template make<unsigned int>());
+	for (unsigned int i = 0; i < objects; i++)
+	{
+		if ((i * 2654435761u + frame) % 3 != 0)
+			visible.push_back(i);
+	}
+
+	std::vector<glm::mat4, MatrixAllocator> instances(alloc.template make<glm::mat4>());
+	instances.reserve(visible.size());
+	for (unsigned int i = 0; i < visible.size(); i++)
+		instances.push_back(glm::translate(glm::mat4(1.0f), glm::vec3((float)visible[i], 0.0f, 0.0f)));
+
+	std::vector<unsigned long long, KeyAllocator> keys(alloc.template make<unsigned long long>());
+	keys.reserve(visible.size());
+	for (unsigned int i = 0; i < visible.size(); i++)
+		keys.push_back(((unsigned long long)((visible[i] * 40503u) & 0xffff) << 32) | visible[i]);
+	std::sort(keys.begin(), keys.end());
+
+	unsigned int length = 0;
+	for (unsigned int i = 0; i < 64; i++)
+	{
+		char number[32];
+		snprintf(number, sizeof(number), "%.3f ms", instances[i % instances.size()][3].x * 0.001f);
+		std::basic_string<char, std::char_traits<char>, CharAllocator> text("object ", alloc.template make<char>());
+		text += number;
+		length += (unsigned int)text.size();
+	}
+	return (unsigned int)(keys.size() + instances.size()) + length;
+}
+
+struct DefaultAllocators {
+	template <typename T>
+	struct Of {
+		typedef std::allocator<T> type;
+	};
+
+	template <typename T>
+	std::allocator<T> make() const
+	{
+		return std::allocator<T>();
+	}
+};
+
+struct FrameArenaAllocators {
+	FrameArena* arena;
+
+	template <typename T>
+	struct Of {
+		typedef ArenaAllocator<T> type;
+	};
+
+	template <typename T>
+	ArenaAllocator<T> make() const
+	{
+		return ArenaAllocator<T>(*arena);
+	}
+};
+
+// Times the same transient per frame work with the default allocator and with a frame arena.
+inline void runArenaBenchmark(unsigned int frames = 2000, unsigned int objects = 5000)
+{
+	std::cout << "Arena benchmark: " << frames << " frames, " << objects << " objects per frame" << std::endl;
+
+	FrameArena arena(1 << 16);
+	FrameArenaAllocators arenaAllocators;
+	arenaAllocators.arena = &arena;
+	const char* names[2] = { "std::allocator", "frame arena" };
+	unsigned int checksum[2] = { 0, 0 };
+	for (int mode = 0; mode < 2; mode++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			if (mode == 0)
+			{
+				checksum[mode] += transientFrameWork(f, objects, DefaultAllocators());
+			}
+			else
+			{
+				arena.beginFrame();
+				checksum[mode] += transientFrameWork(f, objects, arenaAllocators);
+			}
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::fixed << std::setprecision(4)
+			<< "  " << std::setw(16) << std::left << names[mode] << std::right
+			<< ms / frames << " ms/frame" << std::endl;
+	}
+	if (checksum[0] != checksum[1])
+		std::cout << "ERROR::ARENA_BENCHMARK::RESULTS_DIFFER" << std::endl;
+	std::cout << "  arena block grew to " << arena.getCapacity() / 1024 << " KB" << std::endl;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gpuTimer.h"
+#include "seaBenchmarkScene.h"
+#include "seaWaveBake.h"
+#include "shaderPermutations.h"
+
+#include <iostream>
+#include <iomanip>
+
+// Draws the sea at several grid sizes and wave counts, once evaluating the waves per vertex and once
+// baking them with SeaWaveBake at the grid's resolution and fetching them, and reports the time per
+// frame and the GPU time of each. bakedKey is the seaShaders key bit of SEA_BAKED; the noise layers
+// are left off in both so the difference is the wave evaluation.
+inline void runBakeBenchmark(ShaderPermutations& seaShaders, unsigned int bakedKey, unsigned int viewportWidth, unsigned int viewportHeight,
+	unsigned int frames = 120)
+{
+	const unsigned int gridSizes[4] = { 128, 256, 512, 1024 };
+	// the waves of the first Menu preset
+	const glm::vec4 waves[3] = { glm::vec4(-0.072f, 1.0f, 0.346f, 20.0f), glm::vec4(0.855f, -0.536f, 0.417f, 12.814f), glm::vec4(0.449f, 0.362f, 0.712f, 19.026f) };
+	const glm::vec2 origin(-32.0f, -32.0f);
+	const glm::vec2 extent(64.0f, 64.0f);
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)viewportWidth / (float)viewportHeight, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, -60.0f, 40.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	std::cout << "Sea bake benchmark: " << frames << " frames per case, per-vertex waves vs compute bake + fetch" << std::endl;
+
+	glViewport(0, 0, viewportWidth, viewportHeight);
+	glEnable(GL_DEPTH_TEST);
+	for (unsigned int g = 0; g < 4; g++)
+	{
+		unsigned int gridSize = gridSizes[g];
+		SeaGrid seaGrid(gridSize, glm::vec3(origin, 0.0f), glm::vec3(origin + extent, 0.0f), 1.0f);
+
+		SeaWaveBake bake(gridSize, origin, extent);
+		for (unsigned int waveCount = 1; waveCount <= 3; waveCount++)
+		{
+			// each way in a loop of its own, so neither is timed while the GPU still works on the other
+			GpuTimer gpuTimer;
+			unsigned int vertexPass = gpuTimer.addPass("per-vertex");
+			unsigned int bakePass = gpuTimer.addPass("bake");
+			unsigned int fetchPass = gpuTimer.addPass("fetch");
+			Shader& vertexShader = seaShaders.get(waveCount);
+			Shader& bakedShader = seaShaders.get(bakedKey);
+			bakedShader.use();
+			bake.setUniforms(bakedShader, 2, 3);
+			seaGrid.bind();
+
+			double frameMs[2];
+			for (unsigned int mode = 0; mode < 2; mode++)
+			{
+				glFinish();
+				double start = glfwGetTime();
+				for (unsigned int f = 0; f < frames; f++)
+				{
+					float time = (float)f / 60.0f;
+					gpuTimer.beginFrame();
+					glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+					if (mode == 0)
+					{
+						gpuTimer.begin(vertexPass);
+						vertexShader.use();
+						vertexShader.setMat4("projection", projection);
+						vertexShader.setMat4("view", view);
+						vertexShader.setMat4("model", glm::mat4(1.0f));
+						vertexShader.setFloat("gravity", 9.8f);
+						vertexShader.setFloat("time", time);
+						vertexShader.setVec4("waveA", waves[0]);
+						vertexShader.setVec4("waveB", waves[1]);
+						vertexShader.setVec4("waveC", waves[2]);
+						seaGrid.drawElements();
+						gpuTimer.end(vertexPass);
+					}
+					else
+					{
+						gpuTimer.begin(bakePass);
+						bake.bake(9.8f, time, waves, waveCount);
+						gpuTimer.end(bakePass);
+						gpuTimer.begin(fetchPass);
+						bakedShader.use();
+						bakedShader.setMat4("projection", projection);
+						bakedShader.setMat4("view", view);
+						bakedShader.setMat4("model", glm::mat4(1.0f));
+						bakedShader.setMat3("normalMatrix", glm::mat3(1.0f));
+						bake.bindTextures(2, 3);
+						seaGrid.drawElements();
+						gpuTimer.end(fetchPass);
+					}
+				}
+				glFinish();
+				frameMs[mode] = (glfwGetTime() - start) * 1000.0 / frames;
+			}
+			std::cout << std::fixed << std::setprecision(3)
+				<< "  grid " << std::setw(4) << gridSize << ", " << waveCount << (waveCount == 1 ? " wave:  " : " waves: ")
+				<< "per-vertex " << frameMs[0] << " ms/frame (GPU " << gpuTimer.getAverageMs(vertexPass) << " ms), "
+				<< "bake + fetch " << frameMs[1] << " ms/frame (GPU " << gpuTimer.getAverageMs(bakePass) << " + "
+				<< gpuTimer.getAverageMs(fetchPass) << " ms)" << std::endl;
+		}
+	}
+}
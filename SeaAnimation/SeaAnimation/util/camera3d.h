@@ -1,7 +1,6 @@
 #ifndef CAMERA3D_H
 #define CAMERA3D_H
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "seaBenchmarkScene.h"
+#include "shaderPermutations.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+// Finds, for the sea with every wave displacing the grid and with the waves shorter than detailWavelength
+// only bending the normal (DETAIL_WAVES), the coarsest grid whose image is within `tolerance` of a
+// reference drawn on a very fine grid, and reports its vertices and time per frame. The error is the
+// mean difference of the colour channels in 8 bit levels over the sea's pixels, at a few instants of
+// the animation, lit against a low sun so the short waves show in the highlights. The
+// waves are two of the first Menu preset and a short one; detailKeyShift is the first seaShaders key
+// bit of DETAIL_WAVES.
+inline void runDetailBenchmark(ShaderPermutations& seaShaders, unsigned int detailKeyShift, unsigned int viewportWidth, unsigned int viewportHeight,
+	float detailWavelength = 8.0f, float tolerance = 2.0f, unsigned int frames = 60)
+{
+	// longest first, as seaPermutation leaves them once the detail waves are moved to the end
+	const glm::vec4 waves[3] = { glm::vec4(-0.072f, 1.0f, 0.346f, 20.0f), glm::vec4(0.855f, -0.536f, 0.417f, 12.814f), glm::vec4(0.449f, 0.362f, 0.3f, 1.5f) };
+	const unsigned int gridSizes[10] = { 32, 48, 64, 96, 128, 192, 256, 384, 512, 768 };
+	const unsigned int referenceSize = 1536;
+	const float times[4] = { 0.0f, 0.7f, 1.9f, 3.2f };
+	const glm::vec3 initPos(-32.0f, -32.0f, 0.0f);
+	const glm::vec3 finalPos(32.0f, 32.0f, 0.0f);
+	const char* viewNames[2] = { "low", "mid" };
+	const glm::vec3 eyes[2] = { glm::vec3(0.0f, -30.0f, 3.0f), glm::vec3(0.0f, -60.0f, 40.0f) };
+	const glm::vec3 targets[2] = { glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f) };
+
+	unsigned int geometryWaves = 0;
+	while (geometryWaves < 3 && waves[geometryWaves].w >= detailWavelength)
+		geometryWaves++;
+	const char* modeNames[2] = { "all displaced", "detail normals" };
+	unsigned int keys[2] = { 3, geometryWaves | ((3 - geometryWaves) << detailKeyShift) };
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)viewportWidth / (float)viewportHeight, 0.1f, 1000.0f);
+	std::cout << "Sea detail benchmark on " << glGetString(GL_RENDERER) << ": waves of " << waves[0].w << ", " << waves[1].w << " and "
+		<< waves[2].w << " m, " << 3 - geometryWaves << " shorter than " << detailWavelength << " m as normals only, error within "
+		<< tolerance << " levels of a " << referenceSize << "x" << referenceSize << " grid" << std::endl;
+
+	// drawn off screen at the viewport size to read the images back
+	OffscreenTarget target(viewportWidth, viewportHeight);
+	target.bind();
+	glEnable(GL_DEPTH_TEST);
+	// the sky has alpha 0 and is left out of the error
+	glClearColor(0.5f, 0.7f, 0.9f, 0.0f);
+
+	for (unsigned int mode = 0; mode < 2; mode++)
+	{
+		Shader& shader = seaShaders.get(keys[mode]);
+		shader.use();
+		shader.setMat4("projection", projection);
+		shader.setMat4("model", glm::mat4(1.0f));
+		shader.setMat3("normalMatrix", glm::mat3(1.0f));
+		shader.setFloat("gravity", 9.8f);
+		shader.setVec4("waveA", waves[0]);
+		shader.setVec4("waveB", waves[1]);
+		shader.setVec4("waveC", waves[2]);
+		setSeaBenchmarkLighting(shader);
+	}
+
+	// the sea mesh of each size, made when first drawn
+	std::vector<std::unique_ptr<SeaGrid>> grids;
+	auto drawGrid = [&](unsigned int size)
+	{
+		unsigned int g = 0;
+		while (g < grids.size() && grids[g]->getSize() != size)
+			g++;
+		if (g == grids.size())
+			grids.emplace_back(new SeaGrid(size, initPos, finalPos, 1.0f));
+		grids[g]->draw();
+	};
+
+	size_t pixelCount = (size_t)viewportWidth * viewportHeight;
+	std::vector<unsigned char> reference(pixelCount * 4 * 4), image(pixelCount * 4);
+	for (unsigned int v = 0; v < 2; v++)
+	{
+		glm::mat4 view = glm::lookAt(eyes[v], targets[v], glm::vec3(0.0f, 0.0f, 1.0f));
+		auto render = [&](unsigned int mode, unsigned int size, float time)
+		{
+			Shader& shader = seaShaders.get(keys[mode]);
+			shader.use();
+			shader.setMat4("view", view);
+			shader.setVec3("viewPos", eyes[v]);
+			shader.setFloat("time", time);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			drawGrid(size);
+		};
+		for (unsigned int t = 0; t < 4; t++)
+		{
+			render(0, referenceSize, times[t]);
+			target.readPixels(&reference[pixelCount * 4 * t]);
+		}
+
+		std::cout << "  " << viewNames[v] << " view" << std::endl;
+		unsigned int bestVertices[2] = { 0, 0 };
+		for (unsigned int mode = 0; mode < 2; mode++)
+		{
+			// the coarsest grid within the tolerance, the finest if none is
+			unsigned int chosen = gridSizes[9];
+			float chosenError = -1.0f;
+			std::cout << "    " << std::left << std::setw(15) << modeNames[mode] << std::right << std::fixed << std::setprecision(2);
+			for (unsigned int g = 0; g < 10 && chosenError < 0.0f; g++)
+			{
+				SeaImageError imageError;
+				for (unsigned int t = 0; t < 4; t++)
+				{
+					render(mode, gridSizes[g], times[t]);
+					target.readPixels(image.data());
+					imageError.add(image.data(), &reference[pixelCount * 4 * t], pixelCount);
+				}
+				float error = imageError.mean();
+				std::cout << " " << gridSizes[g] << ":" << error;
+				if (error <= tolerance || g == 9)
+				{
+					chosen = gridSizes[g];
+					chosenError = error;
+				}
+			}
+
+			glFinish();
+			double start = glfwGetTime();
+			for (unsigned int f = 0; f < frames; f++)
+				render(mode, chosen, (float)f / 60.0f);
+			glFinish();
+			double frameMs = (glfwGetTime() - start) * 1000.0 / frames;
+			bestVertices[mode] = chosen * chosen;
+			std::cout << std::endl << "      grid " << chosen << " (" << bestVertices[mode] << " vertices), error " << chosenError
+				<< ", " << std::setprecision(3) << frameMs << " ms/frame" << std::endl;
+		}
+		std::cout << "    " << std::setprecision(1) << (float)bestVertices[0] / (float)bestVertices[1] << "x fewer vertices" << std::endl;
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "model.h"
+#include "../shader/shader.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+// meshCount flat, gently rippled grids of about trianglesPerMesh triangles each, side by side, uploaded
+// in the given format
+inline std::vector<Mesh> createFetchMeshes(unsigned int meshCount, unsigned int trianglesPerMesh, VertexFormat format)
+{
+	unsigned int side = 1;
+	while (2 * side * side < trianglesPerMesh)
+		side++;
+	unsigned int n = side + 1;
+
+	std::vector<Mesh> meshes;
+	meshes.reserve(meshCount);
+	for (unsigned int m = 0; m < meshCount; m++)
+	{
+		std::vector<Vertex> vertices(n * n);
+		std::vector<unsigned int> indices;
+		indices.reserve(6 * side * side);
+		float offset = (float)m * 1.5f;
+		for (unsigned int j = 0; j < n; j++)
+		{
+			for (unsigned int i = 0; i < n; i++)
+			{
+				Vertex& vertex = vertices[j * n + i];
+				float u = (float)i / (float)side;
+				float w = (float)j / (float)side;
+				vertex.Position = glm::vec3(offset + u, w, 0.1f * glm::sin(6.0f * u) * glm::cos(6.0f * w));
+				vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+				vertex.TexCoords = glm::vec2(u, w);
+				vertex.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+				vertex.Bitangent = glm::vec3(0.0f, 1.0f, 0.0f);
+				if (i < side && j < side)
+				{
+					unsigned int corner = j * n + i;
+					unsigned int quad[6] = { corner, corner + 1, corner + n + 1, corner + n + 1, corner + n, corner };
+					indices.insert(indices.end(), quad, quad + 6);
+				}
+			}
+		}
+		meshes.push_back(Mesh(vertices, indices, std::vector<Texture>(), format));
+	}
+	return meshes;
+}
+
+// Loads the model at shipPath and a synthetic one of about syntheticTriangles triangles once in every
+// vertex format and reports the GPU vertex data each takes and how fast the vertex shader gets through
+// it. Each pass draws every mesh `passes` times with rasterisation discarded, so the time is vertex
+// fetch and decode alone; the bandwidth counts every vertex of the buffer as read once per draw.
+inline void runFetchBenchmark(Shader& shader, const std::string& shipPath, unsigned int syntheticTriangles = 10000000, unsigned int passes = 20)
+{
+	const VertexFormat formats[3] = { VERTEX_FULL, VERTEX_PACKED, VERTEX_QUANTISED };
+	const char* formatNames[3] = { "full:      ", "packed:    ", "quantised: " };
+	const unsigned int syntheticMeshes = 40;
+
+	std::cout << "Vertex fetch benchmark on " << glGetString(GL_RENDERER) << ": " << passes << " passes per format" << std::endl;
+	shader.use();
+	shader.setMat4("projection", glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f));
+	shader.setMat4("view", glm::lookAt(glm::vec3(0.0f, -20.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+	shader.setMat4("model", glm::mat4(1.0f));
+	shader.setVec3("lightPos", glm::vec3(0.0f, 0.0f, 100.0f));
+	shader.setVec3("viewPos", glm::vec3(0.0f, -20.0f, 10.0f));
+	glEnable(GL_RASTERIZER_DISCARD);
+
+	for (unsigned int source = 0; source < 2; source++)
+	{
+		for (unsigned int f = 0; f < 3; f++)
+		{
+			std::unique_ptr<Model> ship;
+			std::vector<Mesh> synthetic;
+			if (source == 0)
+				ship.reset(new Model(shipPath, false, formats[f]));
+			else
+				synthetic = createFetchMeshes(syntheticMeshes, syntheticTriangles / syntheticMeshes, formats[f]);
+			std::vector<Mesh>& meshes = source == 0 ? ship->meshes : synthetic;
+
+			size_t triangles = 0, vertices = 0, bufferSize = 0;
+			for (unsigned int i = 0; i < meshes.size(); i++)
+			{
+				triangles += meshes[i].indices.size() / 3;
+				vertices += meshes[i].vertices.size();
+				bufferSize += meshes[i].vertexBufferSize;
+			}
+			if (f == 0)
+				std::cout << "  " << (source == 0 ? shipPath : std::string("synthetic")) << ": " << meshes.size() << " meshes, "
+					<< vertices << " vertices, " << triangles << " triangles" << std::endl;
+
+			// the first pass only warms up the buffers and the shader variant
+			double elapsed = 0.0;
+			for (unsigned int pass = 0; pass <= passes; pass++)
+			{
+				glFinish();
+				double start = glfwGetTime();
+				for (unsigned int i = 0; i < meshes.size(); i++)
+					meshes[i].Draw(shader);
+				glFinish();
+				if (pass > 0)
+					elapsed += glfwGetTime() - start;
+			}
+			double passMs = elapsed * 1000.0 / passes;
+			std::cout << "    " << formatNames[f] << std::setw(2) << bufferSize / vertices << " B/vertex, " << std::fixed << std::setprecision(2)
+				<< bufferSize / (1024.0 * 1024.0) << " MB (" << std::setprecision(0)
+				<< 100.0 * (1.0 - (double)bufferSize / (vertices * sizeof(Vertex))) << "% saved), " << std::setprecision(2)
+				<< passMs << " ms/pass, " << std::setprecision(1) << triangles / (passMs * 1000.0) << " M triangles/s, "
+				<< std::setprecision(2) << bufferSize / (passMs * 1e6) << " GB/s" << std::endl;
+			std::cout.unsetf(std::ios::fixed);
+			for (unsigned int i = 0; i < meshes.size(); i++)
+				meshes[i].release();
+		}
+	}
+	glDisable(GL_RASTERIZER_DISCARD);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gpuTimer.h"
+#include "seaBenchmarkScene.h"
+#include "seaPatches.h"
+#include "seaWaveFilter.h"
+#include "shaderPermutations.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+// Draws the sea from a few camera positions with every wave evaluated and with the waves too short for
+// where they are evaluated left out (SeaWaveFilter, WAVE_FILTER), and reports the waves evaluated per
+// vertex and per fragment, the time per frame and the image error of each. The error is the mean
+// difference of the colour channels in 8 bit levels over the sea's pixels from every wave on a very fine
+// grid, supersampled 3 x 3, so waves aliasing count against the unfiltered image too. The cases are the
+// seaSize grid, the tessellated sea and a coarse grid with the shortest wave as detail normals. The waves
+// evaluated are counted by the COUNT_WAVES variants in atomic counters, in a frame of their own.
+inline void runFilterBenchmark(ShaderPermutations& gridShaders, ShaderPermutations& tessShaders, const SeaWaveFilter& filter, unsigned int filterKey,
+	unsigned int countKey, unsigned int detailKeyShift, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int seaSize = 512,
+	unsigned int frames = 60)
+{
+	// longest first, as seaPermutation sorts them
+	const glm::vec4 waves[3] = { glm::vec4(-0.072f, 1.0f, 0.346f, 20.0f), glm::vec4(0.855f, -0.536f, 0.417f, 12.814f), glm::vec4(0.449f, 0.362f, 0.3f, 0.6f) };
+	const glm::vec3 initPos(-32.0f, -32.0f, 0.0f);
+	const glm::vec3 finalPos(32.0f, 32.0f, 0.0f);
+	const char* viewNames[4] = { "low", "mid", "high", "far" };
+	const glm::vec3 eyes[4] = { glm::vec3(0.0f, -30.0f, 3.0f), glm::vec3(0.0f, -60.0f, 40.0f), glm::vec3(0.0f, -10.0f, 120.0f), glm::vec3(0.0f, -220.0f, 90.0f) };
+	const glm::vec3 targets[4] = { glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f) };
+	const char* caseNames[3] = { "grid", "tessellated", "detail normals" };
+	const unsigned int coarseSize = seaGridSize(64.0f, waves[1].w, 8.0f);
+	const unsigned int referenceSize = 1536;
+	const unsigned int caseKeys[3] = { 3, 3, 2 | (1u << detailKeyShift) };
+
+	float fovy = glm::radians(45.0f);
+	glm::mat4 projection = glm::perspective(fovy, (float)viewportWidth / (float)viewportHeight, 0.1f, 1000.0f);
+	float projScale = viewportHeight / (2.0f * glm::tan(0.5f * fovy));
+	std::cout << "Wave filter benchmark on " << glGetString(GL_RENDERER) << ": " << frames << " frames per case, waves of " << waves[0].w << ", "
+		<< waves[1].w << " and " << waves[2].w << " m, left out under " << filter.pixelsPerWave << " pixels or " << filter.samplesPerWave
+		<< " vertices per wavelength; " << seaSize << "x" << seaSize << " grid, 32x32 patches, " << coarseSize << "x" << coarseSize
+		<< " grid with detail normals" << std::endl;
+
+	// drawn off screen to read the images back, at the viewport size and 3 times that for the reference;
+	// the sky has alpha 0
+	const unsigned int supersampling = 3;
+	OffscreenTarget target(viewportWidth, viewportHeight);
+	OffscreenTarget referenceTarget(viewportWidth * supersampling, viewportHeight * supersampling);
+	target.bind();
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.5f, 0.7f, 0.9f, 0.0f);
+
+	// vertices, waves evaluated in them, fragments and detail waves evaluated in them
+	unsigned int counterBuffer;
+	glGenBuffers(1, &counterBuffer);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuffer);
+	glBufferData(GL_ATOMIC_COUNTER_BUFFER, 4 * sizeof(GLuint), NULL, GL_DYNAMIC_READ);
+	glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, counterBuffer);
+
+	const SeaGrid seaGrid(seaSize, initPos, finalPos, 1.0f);
+	const SeaGrid coarseGrid(coarseSize, initPos, finalPos, 1.0f);
+	const SeaGrid referenceGrid(referenceSize, initPos, finalPos, 1.0f);
+	const SeaGrid* grids[3] = { &seaGrid, &coarseGrid, &referenceGrid };
+	SeaPatches seaPatches(32, initPos, finalPos, 1.0f);
+
+	size_t pixelCount = (size_t)viewportWidth * viewportHeight;
+	std::vector<unsigned char> image(pixelCount * 4), supersampled(pixelCount * supersampling * supersampling * 4);
+	std::vector<float> reference(pixelCount * 4);
+	for (unsigned int v = 0; v < 4; v++)
+	{
+		glm::mat4 view = glm::lookAt(eyes[v], targets[v], glm::vec3(0.0f, 0.0f, 1.0f));
+		std::cout << "  " << viewNames[v] << " view" << std::endl;
+		// the reference (case 3) first
+		for (unsigned int step = 0; step < 4; step++)
+		{
+			unsigned int c = (step + 3) % 4;
+			ShaderPermutations& permutations = c == 1 ? tessShaders : gridShaders;
+			unsigned int g = c == 3 ? 2 : (c == 2 ? 1 : 0);
+			float vertexSpacing = (finalPos.x - initPos.x) / (float)(grids[g]->getSize() - 1);
+			auto render = [&](Shader& shader, float time)
+			{
+				shader.use();
+				shader.setMat4("projection", projection);
+				shader.setMat4("view", view);
+				shader.setMat4("model", glm::mat4(1.0f));
+				shader.setMat3("normalMatrix", glm::mat3(1.0f));
+				shader.setVec3("viewPos", eyes[v]);
+				shader.setFloat("gravity", 9.8f);
+				shader.setFloat("time", time);
+				shader.setVec4("waveA", waves[0]);
+				shader.setVec4("waveB", waves[1]);
+				shader.setVec4("waveC", waves[2]);
+				setSeaBenchmarkLighting(shader);
+				filter.setUniforms(shader, projScale, vertexSpacing);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				if (c == 1)
+				{
+					seaPatches.setUniforms(shader, waves, 3, projScale);
+					seaPatches.draw();
+				}
+				else
+				{
+					grids[g]->draw();
+				}
+			};
+
+			if (c == 3)
+			{
+				// every wave, averaged over supersampling x supersampling pixels
+				referenceTarget.bind();
+				render(permutations.get(3), 0.0f);
+				referenceTarget.readPixels(supersampled.data());
+				std::fill(reference.begin(), reference.end(), 0.0f);
+				for (size_t y = 0; y < viewportHeight * supersampling; y++)
+					for (size_t x = 0; x < viewportWidth * supersampling; x++)
+						for (unsigned int ch = 0; ch < 4; ch++)
+							reference[((y / supersampling) * viewportWidth + x / supersampling) * 4 + ch] +=
+								supersampled[(y * viewportWidth * supersampling + x) * 4 + ch] / (float)(supersampling * supersampling);
+				target.bind();
+				continue;
+			}
+
+			std::cout << "    " << std::left << std::setw(15) << caseNames[c] << std::right;
+			for (unsigned int filtered = 0; filtered < 2; filtered++)
+			{
+				unsigned int key = caseKeys[c] | (filtered ? filterKey : 0);
+				GLuint counts[4] = { 0, 0, 0, 0 };
+				glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(counts), counts);
+				render(permutations.get(key | countKey), 0.0f);
+				glMemoryBarrier(GL_ATOMIC_COUNTER_BARRIER_BIT);
+				glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(counts), counts);
+
+				Shader& shader = permutations.get(key);
+				render(shader, 0.0f);
+				target.readPixels(image.data());
+				SeaImageError imageError;
+				imageError.add(image.data(), reference.data(), pixelCount);
+
+				GpuTimer gpuTimer;
+				unsigned int seaPass = gpuTimer.addPass("sea");
+				glFinish();
+				double start = glfwGetTime();
+				for (unsigned int f = 0; f < frames; f++)
+				{
+					gpuTimer.beginFrame();
+					gpuTimer.begin(seaPass);
+					render(shader, (float)f / 60.0f);
+					gpuTimer.end(seaPass);
+				}
+				glFinish();
+				double frameMs = (glfwGetTime() - start) * 1000.0 / frames;
+
+				std::cout << std::fixed << std::setprecision(2) << (filtered ? "  filtered: " : "  all: ")
+					<< (counts[0] > 0 ? (float)counts[1] / (float)counts[0] : 0.0f) << " waves/vertex";
+				if (c == 2)
+					std::cout << " " << (counts[2] > 0 ? (float)counts[3] / (float)counts[2] : 0.0f) << "/fragment";
+				std::cout << ", error " << imageError.mean() << ", "
+					<< std::setprecision(3) << frameMs << " ms/frame (GPU " << gpuTimer.getAverageMs(seaPass) << " ms)";
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	glDeleteBuffers(1, &counterBuffer);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator for data that only lives for a frame: culling lists, sorted draw lists, UI text.
+// Each of the framesInFlight frames owns one block; beginFrame moves on to the next block and rewinds
+// it, so whatever was allocated stays valid until the same block comes round again, which leaves room
+// for data the GPU may still be reading. Freeing is a no-op.
+//
+// A frame that runs out of block gets its extra allocations from the heap, and its block is grown to
+// fit them all the next time it is rewound: once the peak frame has been seen there are no more heap
+// allocations.
+class FrameArena
+{
+public:
+	FrameArena(size_t bytesPerFrame = 1 << 20, unsigned int framesInFlight = 2) :
+		frames(framesInFlight < 1 ? 1 : framesInFlight),
+		current(0)
+	{
+		for (unsigned int i = 0; i < frames.size(); i++)
+			resize(frames[i], bytesPerFrame);
+	}
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// arena of the render loop
+	static FrameArena& shared()
+	{
+		static FrameArena arena;
+		return arena;
+	}
+
+	void beginFrame()
+	{
+		current = (current + 1) % frames.size();
+		Frame& frame = frames[current];
+		if (frame.overflowBytes > 0)
+			resize(frame, frame.capacity + frame.overflowBytes);
+		frame.overflow.clear();
+		frame.overflowBytes = 0;
+		frame.offset = 0;
+	}
+
+	void* allocate(size_t size, size_t alignment = sizeof(void*) * 2)
+	{
+		Frame& frame = frames[current];
+		uintptr_t base = (uintptr_t)frame.block.get();
+		uintptr_t start = (base + frame.offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		if (start + size <= base + frame.capacity)
+		{
+			frame.offset = (size_t)(start + size - base);
+			return (void*)start;
+		}
+
+		frame.overflow.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[size + alignment]));
+		frame.overflowBytes += size + alignment;
+		uintptr_t extra = (uintptr_t)frame.overflow.back().get();
+		return (void*)((extra + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+
+	// bytes handed out by the current frame, overflow included
+	inline size_t getUsed() const
+	{
+		return frames[current].offset + frames[current].overflowBytes;
+	}
+
+	inline size_t getCapacity() const
+	{
+		return frames[current].capacity;
+	}
+
+private:
+	struct Frame {
+		std::unique_ptr<unsigned char[]> block;
+		size_t capacity;
+		size_t offset;
+		std::vector<std::unique_ptr<unsigned char[]>> overflow;
+		size_t overflowBytes;
+	};
+
+	std::vector<Frame> frames;
+	unsigned int current;
+
+	static void resize(Frame& frame, size_t capacity)
+	{
+		frame.block.reset(new unsigned char[capacity]);
+		frame.capacity = capacity;
+		frame.offset = 0;
+		frame.overflowBytes = 0;
+	}
+};
+
+// STL allocator drawing from a FrameArena. Containers using it must not outlive the arena frame they
+// were filled in; growing one leaves its old storage behind until then, so reserve what's known.
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator(FrameArena& frameArena) :
+		arena(&frameArena)
+	{}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) :
+		arena(other.arena)
+	{}
+
+	T* allocate(size_t n)
+	{
+		return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T) > sizeof(void*) * 2 ? alignof(T) : sizeof(void*) * 2));
+	}
+
+	void deallocate(T*, size_t)
+	{}
+
+	FrameArena* arena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena != b.arena;
+}
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> FrameString;
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+// GPU time of named render passes, measured with timestamp queries. Each frame writes its queries
+// into one slot of a ring of `latency` frames and only reads a slot back when it comes round again,
+// by which time the GPU is normally done with it: results are never waited for, a slot whose
+// queries are still pending is skipped instead.
+//
+// Passes may nest or overlap since each one is a pair of timestamps rather than a GL_TIME_ELAPSED
+// query, of which only one can be active at a time.
+class GpuTimer
+{
+public:
+	GpuTimer(unsigned int latency = 4, float smoothing = 0.05f) :
+		slots(latency < 2 ? 2 : latency),
+		alpha(smoothing),
+		frame(0),
+		skipped(0)
+	{}
+
+	~GpuTimer()
+	{
+		for (unsigned int i = 0; i < passes.size(); i++)
+			glDeleteQueries((GLsizei)passes[i].queries.size(), passes[i].queries.data());
+	}
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	// registers a pass, returns the id begin/end take
+	unsigned int addPass(const std::string& name)
+	{
+		Pass pass;
+		pass.name = name;
+		pass.queries.resize(2 * slots);
+		glGenQueries((GLsizei)pass.queries.size(), pass.queries.data());
+		pass.issued.assign(slots, 0);
+		pass.lastMs = 0.0f;
+		pass.averageMs = 0.0f;
+		pass.samples = 0;
+		passes.push_back(pass);
+		return (unsigned int)passes.size() - 1;
+	}
+
+	// call once per frame before any pass: collects the slot about to be reused and moves on to it
+	void beginFrame()
+	{
+		frame++;
+		unsigned int slot = frame % slots;
+		for (unsigned int i = 0; i < passes.size(); i++)
+		{
+			Pass& pass = passes[i];
+			if (!pass.issued[slot])
+				continue;
+			pass.issued[slot] = 0;
+
+			GLuint available = 0;
+			glGetQueryObjectuiv(pass.queries[2 * slot + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				skipped++;
+				continue;
+			}
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(pass.queries[2 * slot], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(pass.queries[2 * slot + 1], GL_QUERY_RESULT, &end);
+			pass.lastMs = (float)((double)(end - start) * 1e-6);
+			pass.averageMs = pass.samples == 0 ? pass.lastMs : pass.averageMs + alpha * (pass.lastMs - pass.averageMs);
+			pass.samples++;
+		}
+	}
+
+	inline void begin(unsigned int pass)
+	{
+		glQueryCounter(passes[pass].queries[2 * (frame % slots)], GL_TIMESTAMP);
+	}
+
+	inline void end(unsigned int pass)
+	{
+		unsigned int slot = frame % slots;
+		glQueryCounter(passes[pass].queries[2 * slot + 1], GL_TIMESTAMP);
+		passes[pass].issued[slot] = 1;
+	}
+
+	inline unsigned int getPassCount() const
+	{
+		return (unsigned int)passes.size();
+	}
+
+	inline const std::string& getName(unsigned int pass) const
+	{
+		return passes[pass].name;
+	}
+
+	// most recent result, `latency` frames old
+	inline float getLastMs(unsigned int pass) const
+	{
+		return passes[pass].lastMs;
+	}
+
+	// results read back so far; getLastMs only has a new one when this changed
+	inline unsigned int getSamples(unsigned int pass) const
+	{
+		return passes[pass].samples;
+	}
+
+	// exponential moving average of the results
+	inline float getAverageMs(unsigned int pass) const
+	{
+		return passes[pass].averageMs;
+	}
+
+	// results dropped because they weren't ready when their slot came round again
+	inline unsigned int getSkipped() const
+	{
+		return skipped;
+	}
+
+private:
+	struct Pass {
+		std::string name;
+		// start and end timestamp of every slot
+		std::vector<GLuint> queries;
+		std::vector<unsigned char> issued;
+		float lastMs;
+		float averageMs;
+		unsigned int samples;
+	};
+
+	std::vector<Pass> passes;
+	unsigned int slots;
+	float alpha;
+	unsigned int frame;
+	unsigned int skipped;
+};
+
+// times the enclosing scope as one pass
+class ScopedGpuTimer
+{
+public:
+	ScopedGpuTimer(GpuTimer& gpuTimer, unsigned int passId) :
+		timer(gpuTimer),
+		pass(passId)
+	{
+		timer.begin(pass);
+	}
+
+	~ScopedGpuTimer()
+	{
+		timer.end(pass);
+	}
+
+private:
+	GpuTimer& timer;
+	unsigned int pass;
+};
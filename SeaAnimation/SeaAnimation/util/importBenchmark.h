@@ -0,0 +1,115 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <assimp/scene.h>
+
+#include "model.h"
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+// Builds a scene with meshCount flat grids of about trianglesPerMesh triangles each, all referenced by
+// the root node. Stands in for the kind of many-mesh file the ship is not.
+inline aiScene* createSyntheticScene(unsigned int meshCount, unsigned int trianglesPerMesh)
+{
+	unsigned int side = 1;
+	while (2 * side * side < trianglesPerMesh)
+		side++;
+	unsigned int n = side + 1;
+
+	aiScene* scene = new aiScene();
+	scene->mNumMaterials = 1;
+	scene->mMaterials = new aiMaterial * [1];
+	scene->mMaterials[0] = new aiMaterial();
+
+	scene->mNumMeshes = meshCount;
+	scene->mMeshes = new aiMesh * [meshCount];
+	scene->mRootNode = new aiNode();
+	scene->mRootNode->mNumMeshes = meshCount;
+	scene->mRootNode->mMeshes = new unsigned int[meshCount];
+
+	for (unsigned int m = 0; m < meshCount; m++)
+	{
+		aiMesh* mesh = new aiMesh();
+		mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		mesh->mMaterialIndex = 0;
+		mesh->mNumVertices = n * n;
+		mesh->mVertices = new aiVector3D[n * n];
+		mesh->mNormals = new aiVector3D[n * n];
+		mesh->mTangents = new aiVector3D[n * n];
+		mesh->mBitangents = new aiVector3D[n * n];
+		mesh->mTextureCoords[0] = new aiVector3D[n * n];
+		mesh->mNumUVComponents[0] = 2;
+		float offset = (float)m * 1.5f;
+		for (unsigned int j = 0; j < n; j++)
+		{
+			for (unsigned int i = 0; i < n; i++)
+			{
+				unsigned int v = j * n + i;
+				float u = (float)i / (float)side;
+				float w = (float)j / (float)side;
+				mesh->mVertices[v].Set(offset + u, w, 0.1f * glm::sin(6.0f * u) * glm::cos(6.0f * w));
+				mesh->mNormals[v].Set(0.0f, 0.0f, 1.0f);
+				mesh->mTangents[v].Set(1.0f, 0.0f, 0.0f);
+				mesh->mBitangents[v].Set(0.0f, 1.0f, 0.0f);
+				mesh->mTextureCoords[0][v].Set(u, w, 0.0f);
+			}
+		}
+		mesh->mNumFaces = 2 * side * side;
+		mesh->mFaces = new aiFace[mesh->mNumFaces];
+		for (unsigned int j = 0; j < side; j++)
+		{
+			for (unsigned int i = 0; i < side; i++)
+			{
+				unsigned int corner = j * n + i;
+				unsigned int quad[6] = { corner, corner + 1, corner + n + 1, corner + n + 1, corner + n, corner };
+				for (unsigned int t = 0; t < 2; t++)
+				{
+					aiFace& face = mesh->mFaces[2 * (j * side + i) + t];
+					face.mNumIndices = 3;
+					face.mIndices = new unsigned int[3];
+					for (unsigned int k = 0; k < 3; k++)
+						face.mIndices[k] = quad[3 * t + k];
+				}
+			}
+		}
+		scene->mMeshes[m] = mesh;
+		scene->mRootNode->mMeshes[m] = m;
+	}
+	return scene;
+}
+
+// times serial against parallel conversion of a synthetic scene, GPU upload included
+inline void runImportBenchmark(unsigned int meshCount, unsigned int trianglesPerMesh, unsigned int repeats = 5)
+{
+	aiScene* scene = createSyntheticScene(meshCount, trianglesPerMesh);
+	std::cout << "Import benchmark: " << meshCount << " meshes x " << trianglesPerMesh << " triangles, "
+		<< ThreadPool::shared().size() + 1 << " threads" << std::endl;
+	if (std::thread::hardware_concurrency() <= 1)
+		std::cout << "  single core: the parallel import falls back to serial" << std::endl;
+
+	for (int parallel = 0; parallel < 2; parallel++)
+	{
+		double best = 1e30;
+		double total = 0.0;
+		for (unsigned int r = 0; r < repeats; r++)
+		{
+			glFinish();
+			double start = glfwGetTime();
+			Model model(scene, ".", false, VERTEX_QUANTISED, false, parallel == 1);
+			glFinish();
+			double elapsed = glfwGetTime() - start;
+			best = elapsed < best ? elapsed : best;
+			total += elapsed;
+			for (unsigned int i = 0; i < model.meshes.size(); i++)
+				model.meshes[i].release();
+		}
+		std::cout << std::fixed << std::setprecision(2)
+			<< (parallel ? "  parallel: " : "  serial:   ")
+			<< best * 1000.0 << " ms best, " << total * 1000.0 / repeats << " ms mean" << std::endl;
+	}
+	delete scene;
+}
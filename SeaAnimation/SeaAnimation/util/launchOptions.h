@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+
+// The value given as the n-th argument after the option at argv[i], or NULL when the option has fewer.
+// An option's values end at the next argument starting with '-', so none of them can be negative.
+inline const char* optionalArgument(int argc, char** argv, int i, int n = 1)
+{
+	for (int k = 1; k <= n; k++)
+	{
+		if (i + k >= argc || argv[i + k][0] == '-')
+			return NULL;
+	}
+	return argv[i + n];
+}
+
+// optionalArgument as a number, fallback when it isn't given
+inline float optionalNumber(int argc, char** argv, int i, float fallback, int n = 1)
+{
+	const char* value = optionalArgument(argc, argv, i, n);
+	return value ? (float)atof(value) : fallback;
+}
+
+// The command line, read once at startup. Values out of range take the option's default; a count or
+// size of 0 leaves the option off.
+struct LaunchOptions
+{
+	// --trace [file]: record CPU scopes from startup, loaders included, and write them as a chrome://tracing
+	// file on exit, trace.json by default
+	std::string traceFile;
+	// --no-program-cache: compile every shader from source, to compare the time to first frame against a
+	// cached start
+	bool programCache;
+	// --hot-reload: rebuild programs in the background when their files in shader/ change
+	bool hotReload;
+
+	// --sea-bake [resolution]: evaluate the waves once per frame into textures with a compute pass
+	// (SeaWaveBake) instead of once per sea vertex, resolution texels a side, 512 by default
+	unsigned int seaBakeResolution;
+	// --sea-loop [frames] [resolution]: bake a looped animation of the waves on load and play it back,
+	// nothing is evaluated per frame until the waves change (SeaLoop); 64 frames at 256 by default, takes
+	// the place of --sea-bake
+	unsigned int seaLoopFrames;
+	unsigned int seaLoopResolution;
+	// --sea-tess [pixels]: draw the sea as patches the GPU tessellates by their size on screen and the
+	// waves' curvature (SeaPatches), a segment off the waves by about pixels at most, 0.5 by default;
+	// takes the place of --sea-bake and --sea-loop
+	float seaTessPixelError;
+	// --sea-detail [wavelength] [grid]: waves shorter than wavelength, 8 by default, only bend the normal
+	// per fragment, so the sea mesh only has to follow the longer ones and is grid vertices a side, 8 per
+	// wavelength when grid is 0; no effect on --sea-bake and --sea-loop, which bake every wave and keep
+	// the 512 grid
+	float seaDetailWavelength;
+	unsigned int seaDetailGrid;
+	// --sea-filter [pixels]: leave out the waves shorter than pixels, 2 by default, or than 2 vertices of
+	// the mesh where they are evaluated (SeaWaveFilter); no effect on --sea-bake and --sea-loop
+	float seaFilterPixels;
+
+	// --benchmark [report.json]: scripted camera, presets and simulation time instead of live input, then
+	// a report and exit
+	bool benchmark;
+	std::string benchmarkFile;
+	// --alloc-check [frames]: run frames past the warm-up, 600 by default, report every one that allocates
+	// on the main thread, then exit with an error if any did
+	bool allocCheck;
+	unsigned int allocCheckFrames;
+
+	// The benchmarks that run on their own and exit, off at 0:
+	// --import-benchmark [meshes]: serial vs parallel model import of a synthetic scene, 500 meshes
+	unsigned int importBenchmarkMeshes;
+	// --arena-benchmark [frames]: transient per frame containers on the default allocator and on a frame
+	// arena, 2000 frames
+	unsigned int arenaBenchmarkFrames;
+	// --fetch-benchmark [passes]: vertex data size and vertex fetch throughput of the ship and a 10M
+	// triangle model in each vertex format, 20 passes
+	unsigned int fetchBenchmarkPasses;
+	// --lod-benchmark [ships]: triangles and frame time of a fleet with and without LOD selection and
+	// cluster culling, 1000 ships
+	unsigned int lodBenchmarkShips;
+	// --bake-benchmark [frames]: GPU time of the sea with per vertex waves and with the compute bake, over
+	// grid sizes and wave counts, 120 frames
+	unsigned int bakeBenchmarkFrames;
+	// --tess-benchmark [frames]: triangles and frame time of the sea as a fixed grid and tessellated, from
+	// a few views, 60 frames
+	unsigned int tessBenchmarkFrames;
+	// --detail-benchmark [wavelength] [tolerance]: vertices the sea needs for the same image error with the
+	// waves shorter than wavelength, 8 by default, displacing the mesh and only bending the normal, within
+	// tolerance levels, 2 by default
+	float detailBenchmarkWavelength;
+	float detailBenchmarkTolerance;
+	// --filter-benchmark [frames]: waves evaluated per vertex and per fragment, frame time and image error
+	// of the sea with and without the waves too short for where they are evaluated, from a few views, 60
+	// frames
+	unsigned int filterBenchmarkFrames;
+
+	LaunchOptions(int argc, char** argv) :
+		programCache(true),
+		hotReload(false),
+		seaBakeResolution(0),
+		seaLoopFrames(0),
+		seaLoopResolution(256),
+		seaTessPixelError(0.0f),
+		seaDetailWavelength(0.0f),
+		seaDetailGrid(0),
+		seaFilterPixels(0.0f),
+		benchmark(false),
+		allocCheck(false),
+		allocCheckFrames(600),
+		importBenchmarkMeshes(0),
+		arenaBenchmarkFrames(0),
+		fetchBenchmarkPasses(0),
+		lodBenchmarkShips(0),
+		bakeBenchmarkFrames(0),
+		tessBenchmarkFrames(0),
+		detailBenchmarkWavelength(0.0f),
+		detailBenchmarkTolerance(0.0f),
+		filterBenchmarkFrames(0)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string option = argv[i];
+			if (option == "--trace")
+			{
+				const char* file = optionalArgument(argc, argv, i);
+				traceFile = file ? file : "trace.json";
+			}
+			else if (option == "--no-program-cache")
+				programCache = false;
+			else if (option == "--hot-reload")
+				hotReload = true;
+			else if (option == "--sea-bake")
+				seaBakeResolution = count(optionalNumber(argc, argv, i, 512.0f), 2, 512);
+			else if (option == "--sea-loop")
+			{
+				seaLoopFrames = count(optionalNumber(argc, argv, i, 64.0f), 1, 64);
+				seaLoopResolution = count(optionalNumber(argc, argv, i, 256.0f, 2), 2, 256);
+			}
+			else if (option == "--sea-tess")
+				seaTessPixelError = positive(optionalNumber(argc, argv, i, 0.5f), 0.5f);
+			else if (option == "--sea-detail")
+			{
+				seaDetailWavelength = positive(optionalNumber(argc, argv, i, 8.0f), 8.0f);
+				seaDetailGrid = count(optionalNumber(argc, argv, i, 0.0f, 2), 2, 0);
+			}
+			else if (option == "--sea-filter")
+				seaFilterPixels = positive(optionalNumber(argc, argv, i, 2.0f), 2.0f);
+			else if (option == "--benchmark")
+			{
+				benchmark = true;
+				const char* file = optionalArgument(argc, argv, i);
+				benchmarkFile = file ? file : "benchmark.json";
+			}
+			else if (option == "--alloc-check")
+			{
+				allocCheck = true;
+				allocCheckFrames = count(optionalNumber(argc, argv, i, 600.0f), 1, 600);
+			}
+			else if (option == "--import-benchmark")
+				importBenchmarkMeshes = count(optionalNumber(argc, argv, i, 500.0f), 1, 500);
+			else if (option == "--arena-benchmark")
+				arenaBenchmarkFrames = count(optionalNumber(argc, argv, i, 2000.0f), 1, 2000);
+			else if (option == "--fetch-benchmark")
+				fetchBenchmarkPasses = count(optionalNumber(argc, argv, i, 20.0f), 1, 20);
+			else if (option == "--lod-benchmark")
+				lodBenchmarkShips = count(optionalNumber(argc, argv, i, 1000.0f), 1, 1000);
+			else if (option == "--bake-benchmark")
+				bakeBenchmarkFrames = count(optionalNumber(argc, argv, i, 120.0f), 1, 120);
+			else if (option == "--tess-benchmark")
+				tessBenchmarkFrames = count(optionalNumber(argc, argv, i, 60.0f), 1, 60);
+			else if (option == "--detail-benchmark")
+			{
+				detailBenchmarkWavelength = positive(optionalNumber(argc, argv, i, 8.0f), 8.0f);
+				detailBenchmarkTolerance = positive(optionalNumber(argc, argv, i, 2.0f, 2), 2.0f);
+			}
+			else if (option == "--filter-benchmark")
+				filterBenchmarkFrames = count(optionalNumber(argc, argv, i, 60.0f), 1, 60);
+		}
+	}
+
+private:
+	// value as a whole number, fallback when it's below minimum
+	static unsigned int count(float value, unsigned int minimum, unsigned int fallback)
+	{
+		return value >= (float)minimum ? (unsigned int)value : fallback;
+	}
+
+	static float positive(float value, float fallback)
+	{
+		return value > 0.0f ? value : fallback;
+	}
+};
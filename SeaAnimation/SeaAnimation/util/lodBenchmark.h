@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "model.h"
+#include "gpuTimer.h"
+#include "frameArena.h"
+#include "../shader/shader.h"
+
+#include <iostream>
+#include <iomanip>
+
+// Draws a fleet of shipCount ships laid out on a grid while the camera circles it at radius 100,
+// once with every ship at full detail, once with LOD selection and once with LOD selection plus
+// cluster culling, and reports the triangles submitted and the time taken per frame.
+inline void runLodBenchmark(Model& ship, Shader& shader, unsigned int viewportWidth, unsigned int viewportHeight,
+	unsigned int shipCount = 1000, unsigned int frames = 120)
+{
+	const float spacing = 8.0f;
+	const float shipScale = 0.1f;
+	unsigned int columns = 1;
+	while (columns * columns < shipCount)
+		columns++;
+	unsigned int rows = (shipCount + columns - 1) / columns;
+	glm::vec3 fleetCenter(0.5f * spacing * (columns - 1), 0.5f * spacing * (rows - 1), 0.0f);
+
+	float fovy = glm::radians(45.0f);
+	glm::mat4 projection = glm::perspective(fovy, (float)viewportWidth / (float)viewportHeight, 0.1f, 1000.0f);
+	float projScale = Model::projectionScale(fovy, (float)viewportHeight);
+
+	unsigned int lodCount = 0;
+	for (unsigned int i = 0; i < ship.meshes.size(); i++)
+		lodCount = ship.meshes[i].lods.size() > lodCount ? (unsigned int)ship.meshes[i].lods.size() : lodCount;
+	std::cout << "LOD benchmark: " << shipCount << " ships, " << frames << " frames, "
+		<< lodCount << " levels, " << ship.lodPixelError << " px error" << std::endl;
+
+	glViewport(0, 0, viewportWidth, viewportHeight);
+	glEnable(GL_DEPTH_TEST);
+	shader.use();
+	shader.setMat4("projection", projection);
+	shader.setVec3("lightPos", glm::vec3(0.0f, 0.0f, 100.0f));
+
+	const char* modes[3] = { "  without LOD:   ", "  with LOD:      ", "  LOD + culling: " };
+	GpuTimer gpuTimer;
+	for (int mode = 0; mode < 3; mode++)
+	{
+		unsigned int fleetPass = gpuTimer.addPass(modes[mode]);
+		ship.trianglesDrawn = 0;
+		glFinish();
+		double start = glfwGetTime();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			FrameArena::shared().beginFrame();
+			float angle = 2.0f * glm::pi<float>() * (float)f / (float)frames;
+			glm::vec3 cameraPos = fleetCenter + glm::vec3(100.0f * glm::cos(angle), 100.0f * glm::sin(angle), 40.0f);
+			glm::mat4 view = glm::lookAt(cameraPos, fleetCenter, glm::vec3(0.0f, 0.0f, 1.0f));
+			glm::mat4 viewProjection = projection * view;
+			shader.setMat4("view", view);
+
+			gpuTimer.beginFrame();
+			ScopedGpuTimer timeFleet(gpuTimer, fleetPass);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			for (unsigned int s = 0; s < shipCount; s++)
+			{
+				glm::vec3 position(spacing * (s % columns), spacing * (s / columns), 0.0f);
+				glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(shipScale));
+				if (mode == 2)
+					ship.Draw(shader, model, viewProjection, cameraPos, projScale);
+				else if (mode == 1)
+					ship.Draw(shader, model, cameraPos, projScale);
+				else
+					ship.Draw(shader, model);
+			}
+		}
+		glFinish();
+		double elapsed = glfwGetTime() - start;
+		std::cout << std::fixed << std::setprecision(2)
+			<< modes[mode]
+			<< ship.trianglesDrawn / frames << " triangles/frame, "
+			<< elapsed * 1000.0 / frames << " ms/frame, "
+			<< gpuTimer.getAverageMs(fleetPass) << " ms GPU" << std::endl;
+	}
+	ship.trianglesDrawn = 0;
+}
@@ -7,9 +7,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "../shader/shader.h"
+#include "vertexPacking.h"
+#include "meshSimplifier.h"
+#include "meshlets.h"
+#include "threadPool.h"
+#include "renderStats.h"
+#include "frameArena.h"
 
 #include <string>
 #include <vector>
+#include <cstring>
 using namespace std;
 
 struct Vertex {
@@ -25,6 +32,13 @@ struct Vertex {
     glm::vec3 Bitangent;
 };
 
+// a level of detail: a range of the index buffer and how far (in model units) it strays from the full mesh
+struct MeshLod {
+    unsigned int indexOffset;
+    unsigned int indexCount;
+    float error;
+};
+
 struct Texture {
     unsigned int id;
     string type;
@@ -38,32 +52,304 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    // layout the vertices are uploaded with, and the bounds quantised positions are relative to
+    VertexFormat format;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsExtent;
+    // bytes taken by the vertex buffer on the GPU
+    size_t vertexBufferSize;
+    // counts stay valid when the CPU copies are dropped after upload
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    // levels of detail, lods[0] is the full mesh. The coarser ones share the vertex buffer and follow
+    // the full index list in the element buffer.
+    vector<MeshLod> lods;
+    vector<unsigned int> lodIndices;
+    // clusters of the full detail level, empty unless buildClusters ran
+    vector<Meshlet> meshlets;
 
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor, takes ownership of the mesh data. With keepCpuCopy = false the vertices and indices
+    // are released as soon as they are on the GPU. With deferUpload = true nothing touches OpenGL yet
+    // and the caller runs beginUpload / writeVertices / finishUpload itself.
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexFormat format = VERTEX_FULL, bool keepCpuCopy = true, bool deferUpload = false)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->format = format;
+        this->keepCpuCopy = keepCpuCopy;
+        vertexCount = (unsigned int)this->vertices.size();
+        indexCount = (unsigned int)this->indices.size();
+        VAO = VBO = EBO = indirectBuffer = 0;
+        mappedVertices = NULL;
+        lods.resize(1);
+        lods[0].indexOffset = 0;
+        lods[0].indexCount = indexCount;
+        lods[0].error = 0.0f;
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        if (!deferUpload)
+        {
+            beginUpload();
+            writeVertices();
+            finishUpload();
+        }
+    }
+
+    // any thread, before finishUpload: simplifies the mesh into up to maxLods - 1 coarser levels, each
+    // aiming at half the triangles of the previous one. Stops early once simplification stalls.
+    void buildLods(unsigned int maxLods = 5)
+    {
+        lods.resize(1);
+        lodIndices.clear();
+        if (maxLods < 2 || indices.size() < 3 * 64)
+            return;
+
+        vector<glm::vec3> positions(vertices.size());
+        glm::vec3 low = vertices.empty() ? glm::vec3(0.0f) : vertices[0].Position;
+        glm::vec3 high = low;
+        for (unsigned int i = 0; i < vertices.size(); i++)
+        {
+            positions[i] = vertices[i].Position;
+            low = glm::min(low, positions[i]);
+            high = glm::max(high, positions[i]);
+        }
+        // beyond a twentieth of the mesh size a level wouldn't be worth showing at any distance
+        float maxError = 0.05f * glm::length(high - low);
+
+        // each level starts from the previous one, so their errors add up
+        vector<unsigned int> previous = indices;
+        float error = 0.0f;
+        while (lods.size() < maxLods && error < maxError)
+        {
+            float levelError = 0.0f;
+            vector<unsigned int> level = MeshSimplifier::simplify(positions, previous, previous.size() / 6 * 3, maxError - error, &levelError);
+            if (level.size() * 10 > previous.size() * 9)
+                break;
+            error += levelError;
+            MeshLod lod;
+            lod.indexOffset = indexCount + (unsigned int)lodIndices.size();
+            lod.indexCount = (unsigned int)level.size();
+            lod.error = error;
+            lods.push_back(lod);
+            lodIndices.insert(lodIndices.end(), level.begin(), level.end());
+            previous.swap(level);
+        }
+    }
+
+    // any thread, before finishUpload: splits the full detail level into meshlets, reordering its indices
+    void buildClusters()
+    {
+        vector<glm::vec3> positions(vertices.size());
+        for (unsigned int i = 0; i < vertices.size(); i++)
+            positions[i] = vertices[i].Position;
+        buildMeshlets(positions, indices, meshlets);
+    }
+
+    // hash of the positions and indices the LODs are built from, to tell whether cached LODs still fit
+    uint64_t lodSourceHash() const
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned int i = 0; i < vertices.size(); i++)
+            hash = hashBytes(hash, &vertices[i].Position, sizeof(glm::vec3));
+        if (!indices.empty())
+            hash = hashBytes(hash, indices.data(), indices.size() * sizeof(unsigned int));
+        return hash;
+    }
+
+    // the coarsest level whose error, seen from distance at projScale pixels per unit at distance 1,
+    // stays under maxPixelError
+    unsigned int selectLod(float scale, float distance, float projScale, float maxPixelError) const
+    {
+        unsigned int lod = 0;
+        float pixelsPerUnit = scale * projScale / glm::max(distance, 1e-4f);
+        while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= maxPixelError)
+            lod++;
+        return lod;
+    }
+
+    // GL thread: creates the buffers and maps the vertex buffer for writing
+    void beginUpload()
+    {
+        // create buffers/arrays
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        vertexBufferSize = vertices.size() * vertexStride();
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
+        if (vertexBufferSize > 0)
+            mappedVertices = glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBufferSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // any thread: computes the bounds and encodes the vertices straight into the mapped buffer
+    void writeVertices()
+    {
+        computeBounds();
+        if (mappedVertices)
+            encodeVertices(mappedVertices);
+    }
+
+    // GL thread: unmaps the vertex buffer, uploads the indices and sets the attribute pointers
+    void finishUpload()
+    {
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        bool written = false;
+        if (mappedVertices)
+        {
+            // GL_FALSE means the buffer's contents were lost while it was mapped and have to be written again
+            written = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+            mappedVertices = NULL;
+        }
+        if (!written && vertexBufferSize > 0)
+        {
+            // mapping failed or its contents were lost, go through a staging copy instead
+            vector<unsigned char> staging(vertexBufferSize);
+            encodeVertices(&staging[0]);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBufferSize, &staging[0]);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (indices.size() + lodIndices.size()) * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
+        if (!indices.empty())
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+        if (!lodIndices.empty())
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), lodIndices.size() * sizeof(unsigned int), lodIndices.data());
+
+        if (format == VERTEX_FULL)
+            setupFullAttributes();
+        else if (format == VERTEX_PACKED)
+            setupPackedAttributes<PackedVertex>();
+        else
+            setupPackedAttributes<QuantisedVertex>();
+
+        glBindVertexArray(0);
+
+        if (!keepCpuCopy)
+        {
+            vector<Vertex>().swap(vertices);
+            vector<unsigned int>().swap(indices);
+        }
+        vector<unsigned int>().swap(lodIndices);
     }
 
-    // render the mesh
-    void Draw(Shader& shader)
+    // deletes the GL objects, the mesh can't be drawn afterwards
+    void release()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        if (indirectBuffer)
+            glDeleteBuffers(1, &indirectBuffer);
+        VAO = VBO = EBO = indirectBuffer = 0;
+    }
+
+    // render the mesh at the given level of detail, returns the number of triangles drawn
+    unsigned int Draw(Shader& shader, unsigned int lod = 0)
+    {
+        bindMaterial(shader);
+
+        // draw mesh
+        const MeshLod& level = lods[lod < lods.size() ? lod : lods.size() - 1];
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, level.indexCount, GL_UNSIGNED_INT, (void*)(level.indexOffset * sizeof(unsigned int)));
+        glBindVertexArray(0);
+        RenderStats::instance().draw(level.indexCount / 3);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+        return level.indexCount / 3;
+    }
+
+    // render the full detail level, skipping the meshlets outside the frustum planes or facing away
+    // from cameraPos (both in model space). Returns the number of triangles drawn.
+    unsigned int DrawClusters(Shader& shader, const glm::vec4 planes[6], const glm::vec3& cameraPos)
+    {
+        // the lists only live until the commands are copied into the indirect buffer
+        FrameVector<DrawElementsIndirectCommand> drawCommands{ ArenaAllocator<DrawElementsIndirectCommand>(FrameArena::shared()) };
+        cullClusters(planes, cameraPos, drawCommands);
+        if (drawCommands.empty())
+            return 0;
+
+        bindMaterial(shader);
+        if (!indirectBuffer)
+            glGenBuffers(1, &indirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        // orphan the previous list, the GPU may still be reading it
+        GLsizeiptr size = (GLsizeiptr)(drawCommands.size() * sizeof(DrawElementsIndirectCommand));
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, size, drawCommands.data(), GL_STREAM_DRAW);
+
+        glBindVertexArray(VAO);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)drawCommands.size(), 0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        glActiveTexture(GL_TEXTURE0);
+        unsigned int triangles = 0;
+        for (unsigned int i = 0; i < drawCommands.size(); i++)
+            triangles += drawCommands[i].count / 3;
+        RenderStats::instance().draw(triangles);
+        return triangles;
+    }
+
+private:
+    // render data 
+    unsigned int VBO, EBO;
+    unsigned int indirectBuffer;
+    // sampler uniform of each texture (texture_diffuse1, texture_specular1...), named once
+    vector<string> samplerNames;
+    bool keepCpuCopy;
+    void* mappedVertices;
+
+    // binds the textures and tells the vertex shader how the vertices are stored
+    void bindMaterial(Shader& shader)
     {
+        if (samplerNames.size() != textures.size())
+            nameSamplers();
+
         // bind appropriate textures
+        for (unsigned int i = 0; i < textures.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+            // now set the sampler to the correct texture unit
+            glUniform1i(glGetUniformLocation(shader.ID, samplerNames[i].c_str()), i);
+            // and finally bind the texture
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+
+        // tell the vertex shader which attributes to read and how to expand quantised positions
+        shader.setBool("packedVertices", format != VERTEX_FULL);
+        if (format == VERTEX_QUANTISED)
+        {
+            shader.setVec3("posOffset", boundsMin);
+            shader.setVec3("posScale", boundsExtent);
+        }
+        else
+        {
+            shader.setVec3("posOffset", glm::vec3(0.0f));
+            shader.setVec3("posScale", glm::vec3(1.0f));
+        }
+    }
+
+    // meshes with at least this many meshlets are culled on the thread pool
+    static const unsigned int parallelCullThreshold = 1024;
+
+    void nameSamplers()
+    {
         unsigned int diffuseNr = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr = 1;
         unsigned int heightNr = 1;
+        samplerNames.resize(textures.size());
         for (unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
-            string name = textures[i].type;
+            const string& name = textures[i].type;
             if (name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
             else if (name == "texture_specular")
@@ -72,45 +358,108 @@ public:
                 number = std::to_string(normalNr++); // transfer unsigned int to stream
             else if (name == "texture_height")
                 number = std::to_string(heightNr++); // transfer unsigned int to stream
+            samplerNames[i] = name + number;
+        }
+    }
 
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    // fills drawCommands with the visible meshlets, neighbours in the index buffer merged into one command
+    void cullClusters(const glm::vec4 planes[6], const glm::vec3& cameraPos, FrameVector<DrawElementsIndirectCommand>& drawCommands)
+    {
+        unsigned int count = (unsigned int)meshlets.size();
+        FrameVector<unsigned char> clusterVisible(count, 0, ArenaAllocator<unsigned char>(FrameArena::shared()));
+        if (count >= parallelCullThreshold)
+        {
+            const unsigned int batch = 256;
+            ThreadPool::shared().parallelFor((count + batch - 1) / batch, [&](unsigned int b)
+            {
+                unsigned int end = (b + 1) * batch < count ? (b + 1) * batch : count;
+                for (unsigned int i = b * batch; i < end; i++)
+                    clusterVisible[i] = meshletVisible(meshlets[i], planes, cameraPos) ? 1 : 0;
+            });
+        }
+        else
+        {
+            for (unsigned int i = 0; i < count; i++)
+                clusterVisible[i] = meshletVisible(meshlets[i], planes, cameraPos) ? 1 : 0;
         }
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        drawCommands.reserve(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (!clusterVisible[i])
+                continue;
+            if (!drawCommands.empty() && clusterVisible[i - 1])
+            {
+                drawCommands.back().count += meshlets[i].indexCount;
+                continue;
+            }
+            DrawElementsIndirectCommand command;
+            command.count = meshlets[i].indexCount;
+            command.instanceCount = 1;
+            command.firstIndex = meshlets[i].indexOffset;
+            command.baseVertex = 0;
+            command.baseInstance = 0;
+            drawCommands.push_back(command);
+        }
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
+    size_t vertexStride() const
+    {
+        if (format == VERTEX_PACKED)
+            return sizeof(PackedVertex);
+        if (format == VERTEX_QUANTISED)
+            return sizeof(QuantisedVertex);
+        return sizeof(Vertex);
+    }
 
-    // initializes all the buffer objects/arrays
-    void setupMesh()
+    void computeBounds()
     {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        if (!vertices.empty())
+        {
+            boundsMin = boundsMax = vertices[0].Position;
+            for (unsigned int i = 1; i < vertices.size(); i++)
+            {
+                boundsMin = glm::min(boundsMin, vertices[i].Position);
+                boundsMax = glm::max(boundsMax, vertices[i].Position);
+            }
+        }
+        boundsExtent = boundsMax - boundsMin;
+    }
 
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    void encodeVertices(void* destination) const
+    {
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        if (format == VERTEX_FULL)
+        {
+            memcpy(destination, vertices.data(), vertices.size() * sizeof(Vertex));
+            return;
+        }
+        for (unsigned int i = 0; i < vertices.size(); i++)
+        {
+            if (format == VERTEX_PACKED)
+                packVertex(vertices[i], ((PackedVertex*)destination)[i]);
+            else
+                packVertex(vertices[i], ((QuantisedVertex*)destination)[i]);
+        }
+    }
 
+    void setupFullAttributes()
+    {
         // set the vertex attribute pointers
         // vertex Positions
         glEnableVertexAttribArray(0);
@@ -127,8 +476,43 @@ private:
         // vertex bitangent
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    }
 
-        glBindVertexArray(0);
+    // compressed layouts live in attributes 5 to 8 so both paths can share shipShader.vs
+    template <typename T>
+    void setupPackedAttributes()
+    {
+        // vertex Positions
+        glEnableVertexAttribArray(5);
+        if (format == VERTEX_QUANTISED)
+            glVertexAttribPointer(5, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(T), (void*)offsetof(T, Position));
+        else
+            glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(T), (void*)offsetof(T, Position));
+        // octahedral normals
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 2, GL_SHORT, GL_TRUE, sizeof(T), (void*)offsetof(T, Normal));
+        // tangent frame quaternions
+        glEnableVertexAttribArray(7);
+        glVertexAttribPointer(7, 4, GL_SHORT, GL_TRUE, sizeof(T), (void*)offsetof(T, TangentFrame));
+        // half float texture coords
+        glEnableVertexAttribArray(8);
+        glVertexAttribPointer(8, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(T), (void*)offsetof(T, TexCoords));
+    }
+
+    void packVertex(const Vertex& vertex, PackedVertex& packed) const
+    {
+        packed.Position = vertex.Position;
+        packed.Normal = encodeOctahedral(vertex.Normal);
+        packed.TangentFrame = encodeTangentFrame(vertex.Normal, vertex.Tangent, vertex.Bitangent);
+        packed.TexCoords = encodeHalfTexCoords(vertex.TexCoords);
+    }
+
+    void packVertex(const Vertex& vertex, QuantisedVertex& packed) const
+    {
+        packed.Position = quantisePosition(vertex.Position, boundsMin, boundsExtent);
+        packed.Normal = encodeOctahedral(vertex.Normal);
+        packed.TangentFrame = encodeTangentFrame(vertex.Normal, vertex.Tangent, vertex.Bitangent);
+        packed.TexCoords = encodeHalfTexCoords(vertex.TexCoords);
     }
 };
 #endif
\ No newline at end of file
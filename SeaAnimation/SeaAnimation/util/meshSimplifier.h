@@ -0,0 +1,475 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+// Quadric error metric simplification by edge collapse (Garland & Heckbert), collapsing vertices
+// onto existing vertices so the uvs, normals and tangents of what is left stay untouched.
+//
+// Vertices are grouped by position. A group with a single vertex away from any open edge is free
+// to move; one on the mesh border can only slide along the border; one on a uv/normal seam (two
+// vertices at the same position) can only slide along the seam, taking both sides with it. Any
+// other group is locked, which keeps seams and borders from tearing or drifting.
+//
+// Meshes with a lot of uv islands would run out of collapses early if every seam junction (several
+// seams meeting at a vertex) was locked, so junctions away from the border may collapse too, their
+// vertices merging into the neighbouring vertices of the target group. That drags the attributes
+// along the collapsed edge, so such a collapse costs at least its length: they only happen once the
+// shape error has grown that large anyway.
+class MeshSimplifier
+{
+public:
+    // Simplifies the triangle list towards targetIndexCount indices, never collapsing an edge that
+    // costs more than maxError (distance, in model units). Returns the new index list and writes the
+    // largest error introduced to resultError.
+    static std::vector<unsigned int> simplify(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+        size_t targetIndexCount, float maxError, float* resultError = NULL)
+    {
+        MeshSimplifier simplifier(positions);
+        std::vector<unsigned int> result = simplifier.run(indices, targetIndexCount, maxError);
+        if (resultError)
+            *resultError = simplifier.error;
+        return result;
+    }
+
+private:
+    enum Kind { MANIFOLD, BORDER, SEAM, JUNCTION, LOCKED };
+
+    struct Quadric {
+        // symmetric 4x4 matrix (a2, ab, ac, ad, b2, bc, bd, c2, cd, d2)
+        double m[10];
+        double weight;
+
+        Quadric() : weight(0.0) { for (int i = 0; i < 10; i++) m[i] = 0.0; }
+
+        static Quadric plane(glm::dvec3 n, double d, double weight)
+        {
+            Quadric q;
+            q.m[0] = n.x * n.x * weight; q.m[1] = n.x * n.y * weight; q.m[2] = n.x * n.z * weight; q.m[3] = n.x * d * weight;
+            q.m[4] = n.y * n.y * weight; q.m[5] = n.y * n.z * weight; q.m[6] = n.y * d * weight;
+            q.m[7] = n.z * n.z * weight; q.m[8] = n.z * d * weight;
+            q.m[9] = d * d * weight;
+            q.weight = weight;
+            return q;
+        }
+
+        void add(const Quadric& other)
+        {
+            for (int i = 0; i < 10; i++)
+                m[i] += other.m[i];
+            weight += other.weight;
+        }
+
+        // weighted mean of the squared distances to the planes
+        double evaluate(glm::dvec3 p) const
+        {
+            if (weight <= 0.0)
+                return 0.0;
+            double r = m[0] * p.x * p.x + 2.0 * m[1] * p.x * p.y + 2.0 * m[2] * p.x * p.z + 2.0 * m[3] * p.x
+                + m[4] * p.y * p.y + 2.0 * m[5] * p.y * p.z + 2.0 * m[6] * p.y
+                + m[7] * p.z * p.z + 2.0 * m[8] * p.z
+                + m[9];
+            return r > 0.0 ? r / weight : 0.0;
+        }
+    };
+
+    struct Collapse {
+        unsigned int from;  // vertex to remove
+        unsigned int to;    // vertex it merges into
+        double cost;
+        bool operator<(const Collapse& other) const { return cost < other.cost; }
+    };
+
+    const std::vector<glm::vec3>& positions;
+    std::vector<unsigned int> group;      // first vertex with the same position
+    std::vector<unsigned int> nextWedge;  // ring of vertices sharing a position
+    std::vector<Quadric> quadrics;        // per group, accumulated over collapses
+    std::vector<unsigned char> kind;      // per group
+    std::vector<unsigned char> used;      // vertex still referenced by a triangle
+    float error;
+
+    MeshSimplifier(const std::vector<glm::vec3>& pos) :
+        positions(pos),
+        error(0.0f)
+    {
+        unsigned int n = (unsigned int)positions.size();
+        group.resize(n);
+        nextWedge.resize(n);
+        quadrics.resize(n);
+        kind.resize(n);
+
+        struct PositionHash {
+            size_t operator()(const glm::vec3& p) const
+            {
+                uint32_t h[3];
+                memcpy(h, &p, sizeof(h));
+                return (size_t)((h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u));
+            }
+        };
+        std::unordered_map<glm::vec3, unsigned int, PositionHash> firstAt;
+        firstAt.reserve(n);
+        for (unsigned int i = 0; i < n; i++)
+        {
+            std::pair<std::unordered_map<glm::vec3, unsigned int, PositionHash>::iterator, bool> it = firstAt.insert(std::make_pair(positions[i], i));
+            unsigned int first = it.first->second;
+            group[i] = first;
+            if (first == i)
+            {
+                nextWedge[i] = i;
+            }
+            else
+            {
+                nextWedge[i] = nextWedge[first];
+                nextWedge[first] = i;
+            }
+        }
+    }
+
+    static inline uint64_t edgeKey(unsigned int a, unsigned int b)
+    {
+        return ((uint64_t)a << 32) | (uint64_t)b;
+    }
+
+    inline glm::dvec3 position(unsigned int v) const
+    {
+        return glm::dvec3(positions[v]);
+    }
+
+    std::vector<unsigned int> run(std::vector<unsigned int> indices, size_t targetIndexCount, float maxError)
+    {
+        // plane quadrics of every triangle, weighted by area
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            glm::dvec3 p0 = position(indices[t]), p1 = position(indices[t + 1]), p2 = position(indices[t + 2]);
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double area = glm::length(normal);
+            if (area <= 0.0)
+                continue;
+            normal /= area;
+            Quadric q = Quadric::plane(normal, -glm::dot(normal, p0), area * 0.5);
+            for (int k = 0; k < 3; k++)
+                quadrics[group[indices[t + k]]].add(q);
+        }
+
+        double maxCost = (double)maxError * (double)maxError;
+        bool bordersAdded = false;
+        while (indices.size() > targetIndexCount)
+        {
+            std::unordered_set<uint64_t> halfEdges, groupHalfEdges;
+            classify(indices, halfEdges, groupHalfEdges);
+            if (!bordersAdded)
+            {
+                addBoundaryQuadrics(indices, halfEdges, groupHalfEdges);
+                bordersAdded = true;
+            }
+
+            std::vector<Collapse> collapses;
+            pickCollapses(indices, halfEdges, groupHalfEdges, collapses);
+            if (collapses.empty())
+                break;
+            std::sort(collapses.begin(), collapses.end());
+
+            std::vector<std::vector<unsigned int>> triangles;
+            buildAdjacency(indices, triangles);
+
+            std::vector<unsigned int> remap(positions.size());
+            for (unsigned int i = 0; i < remap.size(); i++)
+                remap[i] = i;
+            std::vector<unsigned char> touched(positions.size(), 0);
+
+            // each collapse removes about two triangles, stop a pass early when the target is in sight.
+            // Collapses rejected as neighbours of earlier ones are retried in the next pass, so rather
+            // than reaching further down the list for expensive ones the pass stops a little past the
+            // number it needs.
+            size_t trianglesToRemove = (indices.size() - targetIndexCount) / 3;
+            size_t lastCandidate = trianglesToRemove / 2 + trianglesToRemove / 4;
+            double passCost = collapses[lastCandidate < collapses.size() ? lastCandidate : collapses.size() - 1].cost;
+            size_t removed = 0;
+            // if every collapse under the limit got rejected by the flip test, allow the rest
+            for (int attempt = 0; attempt < 2 && removed == 0; attempt++, passCost = maxCost)
+            {
+                for (size_t c = 0; c < collapses.size() && removed < trianglesToRemove; c++)
+                {
+                    const Collapse& collapse = collapses[c];
+                    if (collapse.cost > maxCost || collapse.cost > passCost)
+                        break;
+                    unsigned int ga = group[collapse.from], gb = group[collapse.to];
+                    if (touched[ga] || touched[gb])
+                        continue;
+                    if (flips(indices, triangles, remap, ga, collapse.to))
+                        continue;
+
+                    applyCollapse(collapse, halfEdges, remap);
+                    quadrics[gb].add(quadrics[ga]);
+                    touched[ga] = touched[gb] = 1;
+                    removed += 2;
+                    float e = (float)glm::sqrt(collapse.cost);
+                    error = e > error ? e : error;
+                }
+            }
+            if (removed == 0)
+                break;
+
+            size_t write = 0;
+            for (size_t t = 0; t + 2 < indices.size(); t += 3)
+            {
+                unsigned int a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+                if (a == b || b == c || c == a)
+                    continue;
+                indices[write++] = a;
+                indices[write++] = b;
+                indices[write++] = c;
+            }
+            indices.resize(write);
+        }
+        return indices;
+    }
+
+    void classify(const std::vector<unsigned int>& indices, std::unordered_set<uint64_t>& halfEdges, std::unordered_set<uint64_t>& groupHalfEdges)
+    {
+        halfEdges.reserve(indices.size());
+        groupHalfEdges.reserve(indices.size());
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = indices[t + k], b = indices[t + (k + 1) % 3];
+                halfEdges.insert(edgeKey(a, b));
+                groupHalfEdges.insert(edgeKey(group[a], group[b]));
+            }
+        }
+
+        // open half-edges: border ones are open by position, seam ones only by vertex
+        std::vector<unsigned int> borderOut(positions.size(), 0), borderIn(positions.size(), 0);
+        std::vector<unsigned int> seamOut(positions.size(), 0), seamIn(positions.size(), 0);
+        used.assign(positions.size(), 0);
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = indices[t + k], b = indices[t + (k + 1) % 3];
+                used[a] = 1;
+                if (halfEdges.count(edgeKey(b, a)))
+                    continue;
+                if (!groupHalfEdges.count(edgeKey(group[b], group[a])))
+                {
+                    borderOut[a]++;
+                    borderIn[b]++;
+                }
+                else
+                {
+                    seamOut[a]++;
+                    seamIn[b]++;
+                }
+            }
+        }
+
+        for (unsigned int v = 0; v < positions.size(); v++)
+        {
+            if (group[v] != v)
+                continue;
+            unsigned int wedges = 0, bOut = 0, bIn = 0, seams = 0;
+            bool seamsPaired = true;
+            unsigned int w = v;
+            do
+            {
+                if (used[w])
+                {
+                    wedges++;
+                    bOut += borderOut[w];
+                    bIn += borderIn[w];
+                    seams += seamOut[w] + seamIn[w];
+                    seamsPaired = seamsPaired && seamOut[w] == 1 && seamIn[w] == 1;
+                }
+                w = nextWedge[w];
+            } while (w != v);
+
+            if (wedges == 1 && bOut == 0 && bIn == 0 && seams == 0)
+                kind[v] = MANIFOLD;
+            else if (wedges == 1 && bOut == 1 && bIn == 1 && seams == 0)
+                kind[v] = BORDER;
+            else if (wedges == 2 && bOut == 0 && bIn == 0 && seamsPaired)
+                kind[v] = SEAM;
+            else if (wedges >= 2 && bOut == 0 && bIn == 0)
+                kind[v] = JUNCTION;
+            else
+                kind[v] = LOCKED;
+        }
+    }
+
+    // border and seam edges get an extra plane perpendicular to the surface through the edge, so
+    // sliding along them is cheap but pulling them inwards is not
+    void addBoundaryQuadrics(const std::vector<unsigned int>& indices, const std::unordered_set<uint64_t>& halfEdges, const std::unordered_set<uint64_t>& groupHalfEdges)
+    {
+        const double boundaryWeight = 10.0;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = indices[t + k], b = indices[t + (k + 1) % 3], c = indices[t + (k + 2) % 3];
+                if (halfEdges.count(edgeKey(b, a)))
+                    continue;
+                // seams are open on both sides, only add their plane once
+                if (groupHalfEdges.count(edgeKey(group[b], group[a])) && group[a] > group[b])
+                    continue;
+                glm::dvec3 pa = position(a), pb = position(b), pc = position(c);
+                glm::dvec3 edge = pb - pa;
+                double length = glm::length(edge);
+                glm::dvec3 faceNormal = glm::cross(edge, pc - pa);
+                glm::dvec3 normal = glm::cross(edge, faceNormal);
+                double nl = glm::length(normal);
+                if (length <= 0.0 || nl <= 0.0)
+                    continue;
+                normal /= nl;
+                Quadric q = Quadric::plane(normal, -glm::dot(normal, pa), length * length * boundaryWeight);
+                quadrics[group[a]].add(q);
+                quadrics[group[b]].add(q);
+            }
+        }
+    }
+
+    bool canCollapse(unsigned int from, unsigned int to, const std::unordered_set<uint64_t>& halfEdges, const std::unordered_set<uint64_t>& groupHalfEdges) const
+    {
+        unsigned int ga = group[from], gb = group[to];
+        if (ga == gb)
+            return false;
+        switch (kind[ga])
+        {
+        case MANIFOLD:
+            return true;
+        case BORDER:
+            // only along the border, onto another border vertex or a locked corner
+            return (kind[gb] == BORDER || kind[gb] == LOCKED) &&
+                (!groupHalfEdges.count(edgeKey(gb, ga)) || !groupHalfEdges.count(edgeKey(ga, gb)));
+        case SEAM:
+            // only along the seam, onto another seam vertex so both sides have a vertex to merge into
+            if (kind[gb] == JUNCTION)
+                return true;
+            return kind[gb] == SEAM && !halfEdges.count(edgeKey(to, from));
+        case JUNCTION:
+            return kind[gb] != BORDER && kind[gb] != LOCKED;
+        default:
+            return false;
+        }
+    }
+
+    void pickCollapses(const std::vector<unsigned int>& indices, const std::unordered_set<uint64_t>& halfEdges, const std::unordered_set<uint64_t>& groupHalfEdges,
+        std::vector<Collapse>& collapses)
+    {
+        // cheapest collapse of each group
+        std::vector<Collapse> best(positions.size());
+        std::vector<unsigned char> hasBest(positions.size(), 0);
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                for (int dir = 0; dir < 2; dir++)
+                {
+                    unsigned int a = indices[t + k], b = indices[t + (k + 1) % 3];
+                    if (dir == 1)
+                        std::swap(a, b);
+                    if (!canCollapse(a, b, halfEdges, groupHalfEdges))
+                        continue;
+                    unsigned int ga = group[a];
+                    Quadric q = quadrics[ga];
+                    q.add(quadrics[group[b]]);
+                    double cost = q.evaluate(position(b));
+                    if (kind[ga] == JUNCTION || kind[group[b]] == JUNCTION)
+                    {
+                        glm::dvec3 edge = position(b) - position(a);
+                        cost = glm::max(cost, glm::dot(edge, edge));
+                    }
+                    if (!hasBest[ga] || cost < best[ga].cost)
+                    {
+                        best[ga].from = a;
+                        best[ga].to = b;
+                        best[ga].cost = cost;
+                        hasBest[ga] = 1;
+                    }
+                }
+            }
+        }
+        for (unsigned int v = 0; v < positions.size(); v++)
+        {
+            if (hasBest[v])
+                collapses.push_back(best[v]);
+        }
+    }
+
+    void buildAdjacency(const std::vector<unsigned int>& indices, std::vector<std::vector<unsigned int>>& triangles) const
+    {
+        triangles.assign(positions.size(), std::vector<unsigned int>());
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                std::vector<unsigned int>& list = triangles[group[indices[t + k]]];
+                if (list.empty() || list.back() != (unsigned int)(t / 3))
+                    list.push_back((unsigned int)(t / 3));
+            }
+        }
+    }
+
+    // would moving group ga onto the position of `to` turn any of its triangles over?
+    bool flips(const std::vector<unsigned int>& indices, const std::vector<std::vector<unsigned int>>& triangles,
+        const std::vector<unsigned int>& remap, unsigned int ga, unsigned int to) const
+    {
+        glm::dvec3 target = position(to);
+        const std::vector<unsigned int>& list = triangles[ga];
+        for (unsigned int i = 0; i < list.size(); i++)
+        {
+            size_t t = (size_t)list[i] * 3;
+            unsigned int v[3] = { remap[indices[t]], remap[indices[t + 1]], remap[indices[t + 2]] };
+            glm::dvec3 p[3], q[3];
+            bool degenerate = false;
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = position(v[k]);
+                q[k] = group[v[k]] == ga ? target : p[k];
+                degenerate = degenerate || group[v[k]] == group[to];
+            }
+            // triangles spanning the collapsed edge disappear
+            if (degenerate)
+                continue;
+            glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::dvec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(before, after) <= 0.0)
+                return true;
+        }
+        return false;
+    }
+
+    // every vertex at the position of `from` merges into a vertex of the target group it shares an
+    // edge with, so each side of a seam keeps its own attributes. Vertices with no such neighbour
+    // (a lone vertex, or the far side of a released junction) take the collapse target.
+    void applyCollapse(const Collapse& collapse, const std::unordered_set<uint64_t>& halfEdges, std::vector<unsigned int>& remap) const
+    {
+        unsigned int gb = group[collapse.to];
+        unsigned int w = collapse.from;
+        do
+        {
+            unsigned int target = collapse.to;
+            if (used[w] && w != collapse.from)
+            {
+                unsigned int x = gb;
+                do
+                {
+                    if (used[x] && (halfEdges.count(edgeKey(w, x)) || halfEdges.count(edgeKey(x, w))))
+                    {
+                        target = x;
+                        break;
+                    }
+                    x = nextWedge[x];
+                } while (x != gb);
+            }
+            remap[w] = target;
+            w = nextWedge[w];
+        } while (w != collapse.from);
+    }
+};
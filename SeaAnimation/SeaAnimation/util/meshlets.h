@@ -0,0 +1,251 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdint.h>
+#include <string.h>
+
+// layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+// A cluster of neighbouring triangles, contiguous in the index buffer, with what it takes to cull it:
+// a bounding sphere, and a cone holding the normals of all its triangles.
+struct Meshlet {
+    unsigned int indexOffset;
+    unsigned int indexCount;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    // sine of the angle between the axis and the furthest normal, 1 when the cone is too wide to cull by
+    float coneCutoff;
+};
+
+// Splits a triangle list into meshlets of at most maxVertices vertices and maxTriangles triangles, and
+// reorders indices so each meshlet is one contiguous range. Clusters grow greedily from a seed
+// triangle, always taking the neighbour that adds the fewest new vertices.
+//
+// The mesh is drawn without face culling, so an open surface shows its back through the opening:
+// meshlets touching an open edge never get culled by their normal cone.
+inline void buildMeshlets(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices, std::vector<Meshlet>& meshlets,
+    unsigned int maxVertices = 64, unsigned int maxTriangles = 124)
+{
+    meshlets.clear();
+    unsigned int triangleCount = (unsigned int)(indices.size() / 3);
+    unsigned int vertexCount = (unsigned int)positions.size();
+    if (triangleCount == 0)
+        return;
+
+    // vertices are welded by position for adjacency, uv and normal seams would split the surface otherwise
+    std::vector<unsigned int> weld(vertexCount);
+    {
+        struct PositionHash {
+            size_t operator()(const glm::vec3& p) const
+            {
+                uint32_t h[3];
+                memcpy(h, &p, sizeof(h));
+                return (size_t)((h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u));
+            }
+        };
+        std::unordered_map<glm::vec3, unsigned int, PositionHash> firstAt;
+        firstAt.reserve(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+            weld[v] = firstAt.insert(std::make_pair(positions[v], v)).first->second;
+    }
+
+    // triangles around each position: vertexTriangles[firstTriangle[v] .. firstTriangle[v + 1])
+    std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+        firstTriangle[weld[indices[i]] + 1]++;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        firstTriangle[v + 1] += firstTriangle[v];
+    std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+    std::vector<unsigned int> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+        vertexTriangles[fill[weld[indices[i]]]++] = i / 3;
+
+    // open edges
+    std::unordered_set<uint64_t> halfEdges;
+    halfEdges.reserve(triangleCount * 3);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+    {
+        unsigned int next = i % 3 == 2 ? i - 2 : i + 1;
+        halfEdges.insert(((uint64_t)weld[indices[i]] << 32) | weld[indices[next]]);
+    }
+
+    std::vector<unsigned char> assigned(triangleCount, 0);
+    // meshlet a vertex was last added to, plus one
+    std::vector<unsigned int> vertexMeshlet(vertexCount, 0);
+    std::vector<unsigned int> reordered;
+    reordered.reserve(indices.size());
+    std::vector<unsigned int> meshletVertices;
+    std::vector<unsigned int> meshletTriangles;
+    unsigned int seed = 0;
+
+    while (true)
+    {
+        while (seed < triangleCount && assigned[seed])
+            seed++;
+        if (seed == triangleCount)
+            break;
+
+        unsigned int stamp = (unsigned int)meshlets.size() + 1;
+        meshletVertices.clear();
+        meshletTriangles.clear();
+        glm::vec3 centroidSum(0.0f);
+        unsigned int next = seed;
+
+        while (next != triangleCount)
+        {
+            assigned[next] = 1;
+            meshletTriangles.push_back(next);
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[next * 3 + k];
+                if (vertexMeshlet[v] != stamp)
+                {
+                    vertexMeshlet[v] = stamp;
+                    meshletVertices.push_back(v);
+                }
+                centroidSum += positions[v];
+            }
+            if (meshletTriangles.size() == maxTriangles)
+                break;
+
+            // neighbour adding the fewest vertices, ties broken by distance to the centroid
+            glm::vec3 centroid = centroidSum / (float)(meshletTriangles.size() * 3);
+            unsigned int bestExtra = 4;
+            float bestDistance = 0.0f;
+            next = triangleCount;
+            for (unsigned int i = 0; i < meshletVertices.size(); i++)
+            {
+                unsigned int v = weld[meshletVertices[i]];
+                for (unsigned int j = firstTriangle[v]; j < firstTriangle[v + 1]; j++)
+                {
+                    unsigned int t = vertexTriangles[j];
+                    if (assigned[t])
+                        continue;
+                    unsigned int extra = 0;
+                    glm::vec3 triangleCenter(0.0f);
+                    for (int k = 0; k < 3; k++)
+                    {
+                        unsigned int w = indices[t * 3 + k];
+                        extra += vertexMeshlet[w] != stamp ? 1 : 0;
+                        triangleCenter += positions[w];
+                    }
+                    if (meshletVertices.size() + extra > maxVertices)
+                        continue;
+                    glm::vec3 offset = triangleCenter / 3.0f - centroid;
+                    float distance = glm::dot(offset, offset);
+                    if (extra < bestExtra || (extra == bestExtra && distance < bestDistance))
+                    {
+                        bestExtra = extra;
+                        bestDistance = distance;
+                        next = t;
+                    }
+                }
+            }
+        }
+
+        Meshlet meshlet;
+        meshlet.indexOffset = (unsigned int)reordered.size();
+        meshlet.indexCount = (unsigned int)meshletTriangles.size() * 3;
+
+        // bounding sphere around the box centre
+        glm::vec3 low = positions[meshletVertices[0]], high = low;
+        for (unsigned int i = 1; i < meshletVertices.size(); i++)
+        {
+            low = glm::min(low, positions[meshletVertices[i]]);
+            high = glm::max(high, positions[meshletVertices[i]]);
+        }
+        meshlet.center = 0.5f * (low + high);
+        float radius2 = 0.0f;
+        for (unsigned int i = 0; i < meshletVertices.size(); i++)
+        {
+            glm::vec3 offset = positions[meshletVertices[i]] - meshlet.center;
+            radius2 = glm::max(radius2, glm::dot(offset, offset));
+        }
+        meshlet.radius = glm::sqrt(radius2);
+
+        // normal cone: area weighted mean normal, widened to the furthest triangle normal
+        glm::vec3 normalSum(0.0f);
+        std::vector<glm::vec3> normals(meshletTriangles.size(), glm::vec3(0.0f));
+        bool open = false;
+        for (unsigned int i = 0; i < meshletTriangles.size(); i++)
+        {
+            unsigned int t = meshletTriangles[i];
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = weld[indices[t * 3 + k]], b = weld[indices[t * 3 + (k + 1) % 3]];
+                open = open || !halfEdges.count(((uint64_t)b << 32) | a);
+            }
+            const glm::vec3& p0 = positions[indices[t * 3]];
+            glm::vec3 n = glm::cross(positions[indices[t * 3 + 1]] - p0, positions[indices[t * 3 + 2]] - p0);
+            normalSum += n;
+            float length = glm::length(n);
+            if (length > 0.0f)
+                normals[i] = n / length;
+            for (int k = 0; k < 3; k++)
+                reordered.push_back(indices[t * 3 + k]);
+        }
+        meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.coneCutoff = 1.0f;
+        float axisLength = glm::length(normalSum);
+        if (axisLength > 0.0f && !open)
+        {
+            meshlet.coneAxis = normalSum / axisLength;
+            float minDot = 1.0f;
+            for (unsigned int i = 0; i < normals.size(); i++)
+            {
+                if (normals[i] != glm::vec3(0.0f))
+                    minDot = glm::min(minDot, glm::dot(normals[i], meshlet.coneAxis));
+            }
+            // past 90 degrees some triangle always faces the camera
+            if (minDot > 0.0f)
+                meshlet.coneCutoff = glm::sqrt(1.0f - minDot * minDot);
+        }
+        meshlets.push_back(meshlet);
+    }
+    indices.swap(reordered);
+}
+
+// planes (xyz normal pointing inwards, w distance) of the frustum of a view projection matrix. Given
+// projection * view * model they come out in model space.
+inline void extractFrustumPlanes(const glm::mat4& m, glm::vec4 planes[6])
+{
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+    for (int i = 0; i < 6; i++)
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+// false when the meshlet is outside the frustum, or every triangle in it faces away from the camera.
+// Everything in model space.
+inline bool meshletVisible(const Meshlet& meshlet, const glm::vec4 planes[6], const glm::vec3& cameraPos)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(planes[i]), meshlet.center) + planes[i].w < -meshlet.radius)
+            return false;
+    }
+    // back facing if every point of the sphere sees every normal of the cone from behind
+    glm::vec3 view = meshlet.center - cameraPos;
+    float distance = glm::length(view);
+    return glm::dot(view, meshlet.coneAxis) < meshlet.coneCutoff * distance + meshlet.radius * (1.0f + meshlet.coneCutoff);
+}
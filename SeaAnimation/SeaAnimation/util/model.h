@@ -11,6 +11,10 @@
 #include <assimp/postprocess.h>
 
 #include "mesh.h"
+#include "threadPool.h"
+#include "textureCache.h"
+#include "sceneHierarchy.h"
+#include "profiler.h"
 #include "../shader/shader.h"
 
 #include <string>
@@ -19,39 +23,168 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <memory>
+#include <deque>
+#include <algorithm>
+#include <stdint.h>
 using namespace std;
 
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
-
 class Model
 {
 public:
     // model data 
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
-    vector<Mesh>    meshes;
+    vector<Mesh>    meshes;         // one per mesh in the scene
+    SceneHierarchy  nodes;          // node transforms, each node draws some of the meshes
     string directory;
     bool gammaCorrection;
+    VertexFormat vertexFormat;
+    bool keepCpuCopy;
+    bool parallelImport;
+    // levels of detail per mesh, including the full one; 1 disables simplification
+    unsigned int lodLevels;
+    // largest error, in pixels, a coarser level may show before the finer one is drawn instead
+    float lodPixelError;
+    // split the meshes into clusters at import, so Draw can cull them
+    bool buildClusters;
+    // whether Draw culls clusters against the frustum and by their normal cones when it gets a view
+    bool clusterCulling;
+    // triangles submitted by Draw since the caller last reset it
+    size_t trianglesDrawn;
 
-    // constructor, expects a filepath to a 3D model.
-    Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
+    // constructor, expects a filepath to a 3D model. With keepCpu = false the meshes only live on the GPU once loaded.
+    // With parallel = true the meshes are converted on the shared thread pool and only the GL calls stay on this thread,
+    // when there is more than one core to convert on.
+    // With lods > 1 each mesh gets that many levels of detail, cached next to the model in a .lod file.
+    // With clusters = true the full detail level of each mesh is split into meshlets for culling.
+    Model(string const& path, bool gamma = false, VertexFormat format = VERTEX_FULL, bool keepCpu = true, bool parallel = false, unsigned int lods = 1, bool clusters = false) :
+        gammaCorrection(gamma), vertexFormat(format), keepCpuCopy(keepCpu), parallelImport(parallel), lodLevels(lods), lodPixelError(1.0f),
+        buildClusters(clusters), clusterCulling(true), trianglesDrawn(0)
     {
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader& shader)
+    // builds the model from a scene that is already in memory, textures are looked up relative to dir
+    Model(const aiScene* scene, string const& dir, bool gamma = false, VertexFormat format = VERTEX_FULL, bool keepCpu = true, bool parallel = false, unsigned int lods = 1, bool clusters = false) :
+        directory(dir), gammaCorrection(gamma), vertexFormat(format), keepCpuCopy(keepCpu), parallelImport(parallel), lodLevels(lods), lodPixelError(1.0f),
+        buildClusters(clusters), clusterCulling(true), trianglesDrawn(0)
+    {
+        processScene(scene);
+    }
+
+    // gives the textures back to the cache, they stay resident while other models or the sea use them
+    ~Model()
+    {
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            for (unsigned int j = 0; j < meshes[i].textures.size(); j++)
+                TextureCache::instance().release(meshes[i].textures[j].id);
+        }
+    }
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // bytes of vertex data uploaded to the GPU, and what the same meshes would take as plain Vertex structs
+    size_t vertexBufferSize() const
+    {
+        size_t size = 0;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            size += meshes[i].vertexBufferSize;
+        return size;
+    }
+
+    size_t unpackedVertexBufferSize() const
     {
+        size_t size = 0;
         for (unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+            size += meshes[i].vertexCount * sizeof(Vertex);
+        return size;
+    }
+
+    // pixels covered by one unit at distance one, what LOD errors are scaled by before the distance
+    static float projectionScale(float fovyRadians, float viewportHeight)
+    {
+        return viewportHeight / (2.0f * glm::tan(0.5f * fovyRadians));
+    }
+
+    // draws the model, and thus all its meshes, each with the world transform of its node
+    void Draw(Shader& shader, const glm::mat4& model)
+    {
+        drawNodes(shader, model, NULL, 0.0f, NULL);
+    }
+
+    // same, with each mesh at the coarsest level of detail whose error stays under lodPixelError seen
+    // from cameraPos; projScale comes from projectionScale
+    void Draw(Shader& shader, const glm::mat4& model, const glm::vec3& cameraPos, float projScale)
+    {
+        drawNodes(shader, model, &cameraPos, projScale, NULL);
+    }
+
+    // same, and meshes drawn at full detail only submit the clusters that are inside the frustum of
+    // viewProjection and not facing away from cameraPos
+    void Draw(Shader& shader, const glm::mat4& model, const glm::mat4& viewProjection, const glm::vec3& cameraPos, float projScale)
+    {
+        drawNodes(shader, model, &cameraPos, projScale, clusterCulling ? &viewProjection : NULL);
+    }
+
+    // level of detail a mesh would be drawn at with the given world transform
+    unsigned int selectLod(unsigned int mesh, const glm::mat4& world, const glm::vec3& cameraPos, float projScale) const
+    {
+        const Mesh& m = meshes[mesh];
+        if (m.lods.size() < 2)
+            return 0;
+        float scale = glm::max(glm::length(glm::vec3(world[0])), glm::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+        glm::vec3 center = glm::vec3(world * glm::vec4(m.boundsMin + 0.5f * m.boundsExtent, 1.0f));
+        float radius = 0.5f * glm::length(m.boundsExtent) * scale;
+        // distance to the bounding sphere, the closest any part of the mesh can be
+        float distance = glm::length(center - cameraPos) - radius;
+        return m.selectLod(scale, distance, projScale, lodPixelError);
     }
 
 private:
+    string lodCachePath;
+
+    void drawNodes(Shader& shader, const glm::mat4& model, const glm::vec3* cameraPos, float projScale, const glm::mat4* viewProjection)
+    {
+        nodes.updateWorldTransforms(model);
+        for (unsigned int i = 0; i < nodes.size(); i++)
+        {
+            if (nodes.meshCount[i] == 0)
+                continue;
+            shader.setMat4("model", nodes.world[i]);
+            // clusters are culled in model space
+            glm::vec4 planes[6];
+            glm::vec3 localCamera;
+            if (viewProjection)
+            {
+                extractFrustumPlanes(*viewProjection * nodes.world[i], planes);
+                localCamera = glm::vec3(glm::inverse(nodes.world[i]) * glm::vec4(*cameraPos, 1.0f));
+            }
+            for (unsigned int j = 0; j < nodes.meshCount[i]; j++)
+            {
+                unsigned int mesh = nodes.nodeMeshes[nodes.meshStart[i] + j];
+                unsigned int lod = cameraPos ? selectLod(mesh, nodes.world[i], *cameraPos, projScale) : 0;
+                if (viewProjection && lod == 0 && !meshes[mesh].meshlets.empty())
+                    trianglesDrawn += meshes[mesh].DrawClusters(shader, planes, localCamera);
+                else
+                    trianglesDrawn += meshes[mesh].Draw(shader, lod);
+            }
+        }
+    }
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const& path)
     {
+        PROFILE_SCOPE("Model::loadModel");
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        unsigned int flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+        // simplification needs triangles to share vertices, which some formats (obj) only do once welded
+        if (lodLevels > 1)
+            flags |= aiProcess_JoinIdenticalVertices;
+        PROFILE_BEGIN(read, "assimp ReadFile");
+        const aiScene* scene = importer.ReadFile(path, flags);
+        PROFILE_END(read);
         // check for errors
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
@@ -60,28 +193,222 @@ private:
         }
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
+        lodCachePath = path + ".lod";
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        processScene(scene);
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode* node, const aiScene* scene)
+    // converts every mesh of the scene and uploads it. The conversion (vertex copy, index copy, material
+    // resolution, bounds and vertex packing) runs in parallel, the GL calls run serially on this thread.
+    void processScene(const aiScene* scene)
     {
-        // process each mesh located at the current node
-        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        // flatten ASSIMP's node tree
+        processNodes(scene->mRootNode);
+
+        unsigned int meshCount = scene->mNumMeshes;
+        vector<LodCacheEntry> lodCache;
+        if (lodLevels > 1)
+            readLodCache(meshCount, lodCache);
+        vector<unsigned char> lodsBuilt(meshCount, 0);
+        vector<uint64_t> lodHashes(meshCount, 0);
+
+        vector<unique_ptr<Mesh>> converted(meshCount);
+        forEachMesh(meshCount, [&](unsigned int i)
         {
-            // the node object only contains indices to index the actual objects in the scene. 
-            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            PROFILE_SCOPE("convert mesh");
+            converted[i].reset(new Mesh(processMesh(scene->mMeshes[i], scene)));
+            if (lodLevels > 1)
+            {
+                Mesh& mesh = *converted[i];
+                uint64_t hash = lodHashes[i] = mesh.lodSourceHash();
+                if (i < lodCache.size() && lodCache[i].hash == hash && lodCacheFits(mesh, lodCache[i]))
+                {
+                    mesh.lods.swap(lodCache[i].lods);
+                    mesh.lodIndices.swap(lodCache[i].lodIndices);
+                }
+                else
+                {
+                    PROFILE_SCOPE("build lods");
+                    mesh.buildLods(lodLevels);
+                    lodsBuilt[i] = 1;
+                }
+            }
+            // reorders the full index list, so only once the LODs are hashed
+            if (buildClusters)
+            {
+                PROFILE_SCOPE("build clusters");
+                converted[i]->buildClusters();
+            }
+        });
+        if (lodLevels > 1 && std::find(lodsBuilt.begin(), lodsBuilt.end(), 1) != lodsBuilt.end())
+            writeLodCache(converted, lodHashes);
+
+        PROFILE_BEGIN(upload, "upload meshes");
+        meshes.reserve(meshes.size() + meshCount);
+        unsigned int firstMesh = (unsigned int)meshes.size();
+        for (unsigned int i = 0; i < meshCount; i++)
+        {
+            meshes.push_back(std::move(*converted[i]));
+            converted[i].reset();
+            Mesh& mesh = meshes.back();
+            loadTextures(mesh.textures);
+            mesh.beginUpload();
         }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
-        for (unsigned int i = 0; i < node->mNumChildren; i++)
+
+        forEachMesh(meshCount, [&](unsigned int i)
         {
-            processNode(node->mChildren[i], scene);
+            PROFILE_SCOPE("write vertices");
+            meshes[firstMesh + i].writeVertices();
+        });
+
+        for (unsigned int i = 0; i < meshCount; i++)
+            meshes[firstMesh + i].finishUpload();
+        PROFILE_END(upload);
+    }
+
+    // simplified index lists of one mesh as stored in the .lod file
+    struct LodCacheEntry {
+        uint64_t hash;
+        vector<MeshLod> lods;
+        vector<unsigned int> lodIndices;
+    };
+
+    static const uint32_t lodCacheMagic = 0x444f4c53; // "SLOD"
+    static const uint32_t lodCacheVersion = 1;
+
+    // reads the LODs cached for this model, leaves entries empty when the file is missing, stale or
+    // was built for a different number of levels
+    void readLodCache(unsigned int meshCount, vector<LodCacheEntry>& entries) const
+    {
+        entries.clear();
+        if (lodCachePath.empty())
+            return;
+        ifstream file(lodCachePath.c_str(), ios::binary);
+        if (!file)
+            return;
+        uint32_t header[4];
+        file.read((char*)header, sizeof(header));
+        if (!file || header[0] != lodCacheMagic || header[1] != lodCacheVersion || header[2] != meshCount || header[3] != lodLevels)
+            return;
+
+        entries.resize(meshCount);
+        for (unsigned int i = 0; i < meshCount; i++)
+        {
+            LodCacheEntry& entry = entries[i];
+            uint32_t levels = 0, indexTotal = 0;
+            file.read((char*)&entry.hash, sizeof(entry.hash));
+            file.read((char*)&levels, sizeof(levels));
+            file.read((char*)&indexTotal, sizeof(indexTotal));
+            if (!file || levels == 0 || levels > lodLevels)
+            {
+                entries.clear();
+                return;
+            }
+            entry.lods.resize(levels);
+            file.read((char*)entry.lods.data(), levels * sizeof(MeshLod));
+            entry.lodIndices.resize(indexTotal);
+            if (indexTotal > 0)
+                file.read((char*)entry.lodIndices.data(), indexTotal * sizeof(unsigned int));
+            if (!file)
+            {
+                cout << "ERROR::MODEL::LOD_CACHE_TRUNCATED " << lodCachePath << endl;
+                entries.clear();
+                return;
+            }
+        }
+    }
+
+    // whether a cached entry can be drawn with the mesh: every range within its element buffer, the full
+    // index list followed by the LOD indices, and every LOD index within its vertices. A cache that fails
+    // is rebuilt and written again.
+    bool lodCacheFits(const Mesh& mesh, const LodCacheEntry& entry) const
+    {
+        bool fits = entry.lods[0].indexOffset == 0 && entry.lods[0].indexCount == mesh.indexCount;
+        uint64_t bufferEnd = (uint64_t)mesh.indexCount + entry.lodIndices.size();
+        for (unsigned int l = 1; l < entry.lods.size() && fits; l++)
+        {
+            const MeshLod& lod = entry.lods[l];
+            fits = lod.indexOffset >= mesh.indexCount && lod.indexCount > 0 && lod.indexCount % 3 == 0
+                && (uint64_t)lod.indexOffset + lod.indexCount <= bufferEnd;
+        }
+        for (unsigned int i = 0; i < entry.lodIndices.size() && fits; i++)
+            fits = entry.lodIndices[i] < mesh.vertexCount;
+        if (!fits)
+            cout << "ERROR::MODEL::LOD_CACHE_INVALID " << lodCachePath << endl;
+        return fits;
+    }
+
+    // stores the LODs of every mesh, done on the loading thread while the index lists are still in memory
+    void writeLodCache(const vector<unique_ptr<Mesh>>& converted, const vector<uint64_t>& hashes) const
+    {
+        if (lodCachePath.empty())
+            return;
+        ofstream file(lodCachePath.c_str(), ios::binary | ios::trunc);
+        if (!file)
+        {
+            cout << "ERROR::MODEL::LOD_CACHE_NOT_WRITTEN " << lodCachePath << endl;
+            return;
+        }
+        uint32_t header[4] = { lodCacheMagic, lodCacheVersion, (uint32_t)converted.size(), lodLevels };
+        file.write((const char*)header, sizeof(header));
+        for (unsigned int i = 0; i < converted.size(); i++)
+        {
+            const Mesh& mesh = *converted[i];
+            uint64_t hash = hashes[i];
+            uint32_t levels = (uint32_t)mesh.lods.size();
+            uint32_t indexTotal = (uint32_t)mesh.lodIndices.size();
+            file.write((const char*)&hash, sizeof(hash));
+            file.write((const char*)&levels, sizeof(levels));
+            file.write((const char*)&indexTotal, sizeof(indexTotal));
+            file.write((const char*)mesh.lods.data(), levels * sizeof(MeshLod));
+            if (indexTotal > 0)
+                file.write((const char*)mesh.lodIndices.data(), indexTotal * sizeof(unsigned int));
+        }
+    }
+
+    template <typename F>
+    void forEachMesh(unsigned int count, const F& fn)
+    {
+        // on a single core the pool's handoffs only add to the serial time
+        if (parallelImport && std::thread::hardware_concurrency() > 1)
+        {
+            ThreadPool::shared().parallelFor(count, fn);
+        }
+        else
+        {
+            for (unsigned int i = 0; i < count; i++)
+                fn(i);
         }
+    }
 
+    // flattens the node tree breadth first into the hierarchy, keeping each node's transformation
+    // and the meshes it references
+    void processNodes(aiNode* root)
+    {
+        unsigned int firstMesh = (unsigned int)meshes.size();
+        deque<pair<aiNode*, int>> queue;
+        queue.push_back(make_pair(root, -1));
+        while (!queue.empty())
+        {
+            aiNode* node = queue.front().first;
+            int parent = queue.front().second;
+            queue.pop_front();
+
+            aiVector3D scaling, position;
+            aiQuaternion rotation;
+            node->mTransformation.Decompose(scaling, rotation, position);
+            unsigned int index = nodes.addNode(parent, node->mName.C_Str(),
+                glm::vec3(position.x, position.y, position.z),
+                glm::quat(rotation.w, rotation.x, rotation.y, rotation.z),
+                glm::vec3(scaling.x, scaling.y, scaling.z));
+            // the node object only contains indices to index the actual objects in the scene. 
+            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+            for (unsigned int i = 0; i < node->mNumMeshes; i++)
+                nodes.addMesh(firstMesh + node->mMeshes[i]);
+
+            for (unsigned int i = 0; i < node->mNumChildren; i++)
+                queue.push_back(make_pair(node->mChildren[i], (int)index));
+        }
     }
 
     Mesh processMesh(aiMesh* mesh, const aiScene* scene)
@@ -90,6 +417,8 @@ private:
         vector<Vertex> vertices;
         vector<unsigned int> indices;
         vector<Texture> textures;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         // walk through each of the mesh's vertices
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -137,7 +466,7 @@ private:
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for (unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
             for (unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
@@ -152,94 +481,41 @@ private:
         // normal: texture_normalN
 
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        resolveMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        resolveMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures);
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        resolveMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", textures);
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        resolveMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", textures);
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return a mesh object created from the extracted mesh data, uploaded later by processScene
+        return Mesh(std::move(vertices), std::move(indices), std::move(textures), vertexFormat, keepCpuCopy, true);
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
+    // appends the material textures of a given type, only type and path are filled in: this runs on the
+    // worker threads, the ids are assigned on the GL thread by loadTextures.
+    void resolveMaterialTextures(aiMaterial* mat, aiTextureType type, const char* typeName, vector<Texture>& textures) const
     {
-        vector<Texture> textures;
         for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for (unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if (!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            Texture texture;
+            texture.id = 0;
+            texture.type = typeName;
+            texture.path = str.C_Str();
+            textures.push_back(texture);
         }
-        return textures;
     }
-};
-
-
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
-{
-    string filename = string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+    // fills in the ids of the given textures from the shared texture cache, which only loads the ones
+    // no model has loaded yet. Each id taken here is given back in the destructor.
+    void loadTextures(vector<Texture>& textures)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        TextureSettings settings(GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, true, gammaCorrection);
+        for (unsigned int i = 0; i < textures.size(); i++)
+            textures[i].id = TextureCache::instance().acquire(directory + '/' + textures[i].path, settings);
     }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-#endif
\ No newline at end of file
+};
+#endif
@@ -4,10 +4,69 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <fstream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
 
+// timings of one frame; stages are whatever the application registered with addStage
+struct FrameSample {
+	static const unsigned int maxStages = 8;
+
+	uint64_t frame;
+	double time;        // seconds, as passed to update
+	float cpuMs;        // time between this update and the previous one
+	float gpuMs;        // last GPU frame time known when the frame ended, 0 if not provided
+	float stageMs[maxStages];
+};
+
+// distribution of the frame times currently in the ring
+struct FrameStats {
+	unsigned int count;
+	float mean;
+	float p50;
+	float p95;
+	float p99;
+	float max;
+
+	FrameStats() : count(0), mean(0.0f), p50(0.0f), p95(0.0f), p99(0.0f), max(0.0f) {}
+};
+
+// a frame that took more than hitchFactor times the median, and the stage that went over its usual time the most;
+// the name is copied into the hitch, which the frame thread records without allocating
+struct Hitch {
+	static const unsigned int maxStageName = 32;
+
+	uint64_t frame;
+	double time;
+	float ms;
+	float medianMs;
+	char stage[maxStageName];
+};
+
+// Frame timing. The window average (getFPS/getMS) is what the title bar shows; on top of that every
+// frame goes into a ring of samples, from which percentiles, a histogram and hitches are derived.
+//
+// The ring is written by the render thread only and can be read from any thread without locks: each
+// slot carries a sequence number that is odd while it is being written, readers drop slots that
+// were odd or changed while they copied them. The sample itself is stored as atomic words, so a
+// reader copying a slot the writer is overwriting reads stale words rather than racing it. Stats,
+// histogram and hitches are refreshed once per period on the render thread and are meant to be read
+// there.
 class PerformanceMonitor
 {
 private:
+	static const unsigned int sampleWords = sizeof(FrameSample) / sizeof(uint32_t);
+	static_assert(sizeof(FrameSample) % sizeof(uint32_t) == 0, "FrameSample must be a whole number of words");
+
+	struct Slot {
+		std::atomic<uint32_t> sequence;
+		std::atomic<uint32_t> words[sampleWords];
+	};
+
 	float currentTime;
 	float timer;
 	float period;
@@ -15,28 +74,123 @@ private:
 	float framesPerSecond;
 	float msPerFrame;
 
+	// ring of samples, capacity is a power of two
+	std::vector<Slot> ring;
+	std::atomic<uint64_t> written;
+
+	// stages of the frame being recorded
+	std::vector<std::string> stageNames;
+	float pendingStageMs[FrameSample::maxStages];
+	float stageAverageMs[FrameSample::maxStages];
+	std::chrono::steady_clock::time_point stageStart[FrameSample::maxStages];
+	float pendingGpuMs;
+
+	// refreshed every period
+	FrameStats cpuStats;
+	FrameStats gpuStats;
+	std::vector<unsigned int> histogram;
+	float histogramBucketMs;
+	float medianMs;
+	std::vector<FrameSample> statsSamples;
+	std::vector<float> statsCpu;
+	std::vector<float> statsGpu;
+
+	// ring of the last maxHitches hitches, allocated up front
+	std::vector<Hitch> hitches;
+	unsigned int maxHitches;
+	unsigned int hitchCount;
+	unsigned int nextHitch;
+
 public:
-	PerformanceMonitor(float ctTime, float prd) :
+	float hitchFactor;
+
+	PerformanceMonitor(float ctTime, float prd, unsigned int capacity = 4096) :
 		currentTime(ctTime),
 		timer(0.0f),
 		period(prd),
 		framesCounter(0),
 		framesPerSecond(0.0f),
-		msPerFrame(0.0f)
-	{}
+		msPerFrame(0.0f),
+		written(0),
+		pendingGpuMs(0.0f),
+		histogram(50, 0),
+		histogramBucketMs(1.0f),
+		medianMs(0.0f),
+		maxHitches(256),
+		hitchCount(0),
+		nextHitch(0),
+		hitchFactor(2.0f)
+	{
+		unsigned int size = 1;
+		while (size < capacity)
+			size *= 2;
+		ring = std::vector<Slot>(size);
+		for (unsigned int i = 0; i < size; i++)
+		{
+			ring[i].sequence.store(0, std::memory_order_relaxed);
+			for (unsigned int w = 0; w < sampleWords; w++)
+				ring[i].words[w].store(0, std::memory_order_relaxed);
+		}
+		hitches.resize(maxHitches);
+		statsSamples.reserve(size);
+		statsCpu.reserve(size);
+		statsGpu.reserve(size);
+		for (unsigned int i = 0; i < FrameSample::maxStages; i++)
+		{
+			pendingStageMs[i] = 0.0f;
+			stageAverageMs[i] = 0.0f;
+		}
+	}
+
+	PerformanceMonitor(const PerformanceMonitor&) = delete;
+	PerformanceMonitor& operator=(const PerformanceMonitor&) = delete;
+
+	// registers a stage of the frame, returns the id for stageBegin/stageEnd (at most FrameSample::maxStages)
+	unsigned int addStage(const std::string& name)
+	{
+		if (stageNames.size() == FrameSample::maxStages)
+		{
+			std::cout << "ERROR::PERFORMANCE_MONITOR::TOO_MANY_STAGES " << name << std::endl;
+			return FrameSample::maxStages - 1;
+		}
+		stageNames.push_back(name);
+		return (unsigned int)stageNames.size() - 1;
+	}
 
+	inline void stageBegin(unsigned int stage)
+	{
+		stageStart[stage] = std::chrono::steady_clock::now();
+	}
+
+	// a stage may run several times in a frame, its times add up
+	inline void stageEnd(unsigned int stage)
+	{
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - stageStart[stage];
+		pendingStageMs[stage] += elapsed.count();
+	}
+
+	inline void setGpuFrameMs(float ms)
+	{
+		pendingGpuMs = ms;
+	}
+
+	// ends the frame that started at the previous update
 	void update(float cTime)
 	{
+		float frameMs = 1000.0f * (cTime - currentTime);
 		framesCounter += 1;
 		timer += cTime - currentTime;
 		currentTime = cTime;
 
+		recordFrame(cTime, frameMs);
+
 		if (timer > period)
 		{
 			framesPerSecond = framesCounter / timer;
 			msPerFrame = 1000.0 * timer / framesCounter;
 			framesCounter = 0;
 			timer = 0.0f;
+			refreshStats();
 		}
 	}
 
@@ -49,11 +203,252 @@ public:
 	{
 		return msPerFrame;
 	}
+
+	inline const FrameStats& getCpuStats() const
+	{
+		return cpuStats;
+	}
+
+	inline const FrameStats& getGpuStats() const
+	{
+		return gpuStats;
+	}
+
+	// frame counts per bucket of getHistogramBucketMs, the last bucket holds everything above
+	inline const std::vector<unsigned int>& getHistogram() const
+	{
+		return histogram;
+	}
+
+	inline float getHistogramBucketMs() const
+	{
+		return histogramBucketMs;
+	}
+
+	inline unsigned int getHitchCount() const
+	{
+		return hitchCount;
+	}
+
+	// the i-th of the hitches kept, oldest first
+	inline const Hitch& getHitch(unsigned int i) const
+	{
+		return hitches[(nextHitch + maxHitches - hitchCount + i) % maxHitches];
+	}
+
+	inline const std::vector<std::string>& getStageNames() const
+	{
+		return stageNames;
+	}
+
+	inline uint64_t getFrameCount() const
+	{
+		return written.load(std::memory_order_acquire);
+	}
+
+	// copies up to maxCount of the most recent samples, oldest first. Safe from any thread.
+	void snapshot(std::vector<FrameSample>& samples, size_t maxCount = (size_t)-1) const
+	{
+		samples.clear();
+		uint64_t end = written.load(std::memory_order_acquire);
+		uint64_t count = end < ring.size() ? end : ring.size();
+		if (count > maxCount)
+			count = maxCount;
+		samples.reserve((size_t)count);
+		for (uint64_t i = end - count; i < end; i++)
+		{
+			const Slot& slot = ring[(size_t)(i & (ring.size() - 1))];
+			uint32_t before = slot.sequence.load(std::memory_order_acquire);
+			if (before & 1)
+				continue;
+			uint32_t words[sampleWords];
+			for (unsigned int w = 0; w < sampleWords; w++)
+				words[w] = slot.words[w].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) != before)
+				continue;
+			FrameSample sample;
+			memcpy(&sample, words, sizeof(sample));
+			if (sample.frame != i)
+				continue;
+			samples.push_back(sample);
+		}
+	}
+
+	// one row per frame: frame, time, cpu and gpu ms, then every stage
+	bool writeCsv(const std::string& path) const
+	{
+		std::ofstream file(path.c_str());
+		if (!file)
+		{
+			std::cout << "ERROR::PERFORMANCE_MONITOR::FILE_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		std::vector<FrameSample> samples;
+		snapshot(samples);
+		file << "frame,time,cpu_ms,gpu_ms";
+		for (unsigned int s = 0; s < stageNames.size(); s++)
+			file << "," << stageNames[s] << "_ms";
+		file << "\n" << std::fixed << std::setprecision(4);
+		for (unsigned int i = 0; i < samples.size(); i++)
+		{
+			file << samples[i].frame << "," << samples[i].time << "," << samples[i].cpuMs << "," << samples[i].gpuMs;
+			for (unsigned int s = 0; s < stageNames.size(); s++)
+				file << "," << samples[i].stageMs[s];
+			file << "\n";
+		}
+		return true;
+	}
+
+	// summary: percentiles, histogram and hitches
+	bool writeJson(const std::string& path) const
+	{
+		std::ofstream file(path.c_str());
+		if (!file)
+		{
+			std::cout << "ERROR::PERFORMANCE_MONITOR::FILE_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		file << std::fixed << std::setprecision(4) << "{\n";
+		file << "  \"frames\": " << getFrameCount() << ",\n";
+		file << "  \"cpu\": ";
+		writeStatsJson(file, cpuStats);
+		file << ",\n  \"gpu\": ";
+		writeStatsJson(file, gpuStats);
+		file << ",\n  \"histogram\": { \"bucket_ms\": " << histogramBucketMs << ", \"counts\": [";
+		for (unsigned int i = 0; i < histogram.size(); i++)
+			file << (i ? ", " : "") << histogram[i];
+		file << "] },\n  \"hitch_factor\": " << hitchFactor << ",\n  \"hitches\": [";
+		for (unsigned int i = 0; i < hitchCount; i++)
+		{
+			const Hitch& hitch = getHitch(i);
+			file << (i ? "," : "") << "\n    { \"frame\": " << hitch.frame << ", \"time\": " << hitch.time
+				<< ", \"ms\": " << hitch.ms << ", \"median_ms\": " << hitch.medianMs
+				<< ", \"stage\": \"" << hitch.stage << "\" }";
+		}
+		file << (hitchCount == 0 ? "" : "\n  ") << "]\n}\n";
+		return true;
+	}
+
+	// mean and percentiles of values, which get sorted
+	static FrameStats computeStats(std::vector<float>& values)
+	{
+		FrameStats stats;
+		if (values.empty())
+			return stats;
+		std::sort(values.begin(), values.end());
+		double sum = 0.0;
+		for (unsigned int i = 0; i < values.size(); i++)
+			sum += values[i];
+		stats.count = (unsigned int)values.size();
+		stats.mean = (float)(sum / values.size());
+		stats.p50 = percentile(values, 0.50f);
+		stats.p95 = percentile(values, 0.95f);
+		stats.p99 = percentile(values, 0.99f);
+		stats.max = values.back();
+		return stats;
+	}
+
+	// nearest rank on sorted values
+	static float percentile(const std::vector<float>& sorted, float p)
+	{
+		size_t rank = (size_t)(p * (float)sorted.size() + 0.5f);
+		rank = rank > 0 ? rank - 1 : 0;
+		return sorted[rank < sorted.size() ? rank : sorted.size() - 1];
+	}
+
+	static void writeStatsJson(std::ostream& os, const FrameStats& stats)
+	{
+		os << "{ \"count\": " << stats.count << ", \"mean_ms\": " << stats.mean << ", \"p50_ms\": " << stats.p50
+			<< ", \"p95_ms\": " << stats.p95 << ", \"p99_ms\": " << stats.p99 << ", \"max_ms\": " << stats.max << " }";
+	}
+
+private:
+	void recordFrame(double time, float frameMs)
+	{
+		uint64_t index = written.load(std::memory_order_relaxed);
+		Slot& slot = ring[(size_t)(index & (ring.size() - 1))];
+		FrameSample sample;
+		sample.frame = index;
+		sample.time = time;
+		sample.cpuMs = frameMs;
+		sample.gpuMs = pendingGpuMs;
+		for (unsigned int s = 0; s < FrameSample::maxStages; s++)
+			sample.stageMs[s] = pendingStageMs[s];
+		uint32_t words[sampleWords];
+		memcpy(words, &sample, sizeof(sample));
+
+		uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (unsigned int w = 0; w < sampleWords; w++)
+			slot.words[w].store(words[w], std::memory_order_relaxed);
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+		written.store(index + 1, std::memory_order_release);
+
+		if (medianMs > 0.0f && frameMs > hitchFactor * medianMs)
+			recordHitch(sample);
+
+		// stage averages to tell which one a hitch came from
+		for (unsigned int s = 0; s < stageNames.size(); s++)
+		{
+			stageAverageMs[s] = index == 0 ? pendingStageMs[s] : stageAverageMs[s] + 0.05f * (pendingStageMs[s] - stageAverageMs[s]);
+			pendingStageMs[s] = 0.0f;
+		}
+	}
+
+	void recordHitch(const FrameSample& sample)
+	{
+		Hitch& hitch = hitches[nextHitch];
+		nextHitch = (nextHitch + 1) % maxHitches;
+		hitchCount = hitchCount < maxHitches ? hitchCount + 1 : maxHitches;
+		hitch.frame = sample.frame;
+		hitch.time = sample.time;
+		hitch.ms = sample.cpuMs;
+		hitch.medianMs = medianMs;
+		const char* stage = "unattributed";
+		// the stage has to account for a fair part of the extra time to take the blame
+		float worst = 0.25f * (sample.cpuMs - medianMs);
+		for (unsigned int s = 0; s < stageNames.size(); s++)
+		{
+			float excess = sample.stageMs[s] - stageAverageMs[s];
+			if (excess > worst)
+			{
+				worst = excess;
+				stage = stageNames[s].c_str();
+			}
+		}
+		strncpy(hitch.stage, stage, Hitch::maxStageName - 1);
+		hitch.stage[Hitch::maxStageName - 1] = '\0';
+	}
+
+	void refreshStats()
+	{
+		// scratch kept between refreshes, the frame loop shouldn't allocate
+		std::vector<FrameSample>& samples = statsSamples;
+		std::vector<float>& cpu = statsCpu;
+		std::vector<float>& gpu = statsGpu;
+		snapshot(samples);
+		cpu.clear();
+		gpu.clear();
+		std::fill(histogram.begin(), histogram.end(), 0);
+		for (unsigned int i = 0; i < samples.size(); i++)
+		{
+			cpu.push_back(samples[i].cpuMs);
+			if (samples[i].gpuMs > 0.0f)
+				gpu.push_back(samples[i].gpuMs);
+			unsigned int bucket = (unsigned int)(samples[i].cpuMs / histogramBucketMs);
+			histogram[bucket < histogram.size() ? bucket : histogram.size() - 1]++;
+		}
+		cpuStats = computeStats(cpu);
+		gpuStats = computeStats(gpu);
+		medianMs = cpuStats.p50;
+	}
 };
 
-std::ostream& operator<<(std::ostream& os, const PerformanceMonitor perfMonitor) {
+inline std::ostream& operator<<(std::ostream& os, const PerformanceMonitor& perfMonitor) {
 	os << std::fixed << std::setprecision(2)
 		<< "[" << perfMonitor.getFPS() << " fps - "
 		<< perfMonitor.getMS() << " ms]";
 	return os;
-}
\ No newline at end of file
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Primitives the GPU generated between begin() and end() (GL_PRIMITIVES_GENERATED), for draws whose
+// triangle count isn't known on the CPU, like the tessellated sea. Like GpuTimer it keeps a ring of
+// `latency` queries and only reads one back when it comes round again and is available, so the
+// count lags a few frames and is never waited for.
+class PrimitiveCounter
+{
+public:
+	PrimitiveCounter(unsigned int latency = 4) :
+		queries(latency < 2 ? 2 : latency),
+		issued(queries.size(), 0),
+		frame(0),
+		last(0)
+	{
+		glGenQueries((GLsizei)queries.size(), queries.data());
+	}
+
+	~PrimitiveCounter()
+	{
+		glDeleteQueries((GLsizei)queries.size(), queries.data());
+	}
+
+	PrimitiveCounter(const PrimitiveCounter&) = delete;
+	PrimitiveCounter& operator=(const PrimitiveCounter&) = delete;
+
+	void begin()
+	{
+		frame++;
+		unsigned int slot = frame % queries.size();
+		if (issued[slot])
+		{
+			GLuint available = 0;
+			glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available)
+				glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT, &last);
+		}
+		glBeginQuery(GL_PRIMITIVES_GENERATED, queries[slot]);
+	}
+
+	void end()
+	{
+		glEndQuery(GL_PRIMITIVES_GENERATED);
+		issued[frame % queries.size()] = 1;
+	}
+
+	// the latest count read back
+	unsigned int getLast() const
+	{
+		return last;
+	}
+
+	// waits for the count of the last begin() / end(), for benchmarks
+	unsigned int waitLast()
+	{
+		GLuint count = 0;
+		glGetQueryObjectuiv(queries[frame % queries.size()], GL_QUERY_RESULT, &count);
+		last = count;
+		return last;
+	}
+
+private:
+	std::vector<GLuint> queries;
+	std::vector<char> issued;
+	unsigned long long frame;
+	GLuint last;
+};
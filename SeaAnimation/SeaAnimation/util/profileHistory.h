@@ -0,0 +1,88 @@
+#pragma once
+
+#include "profiler.h"
+
+#include <vector>
+#include <string.h>
+
+// one frame of scopes recorded on the thread that updates the history
+struct ProfiledFrame {
+	int64_t startNs;
+	int64_t durationNs;
+	// every scope inside the frame, the frame scope itself included at depth 0
+	std::vector<ProfileEvent> events;
+};
+
+// The last `capacity` frames of CPU scopes, for the profiler panel. update() pulls what the profiler
+// recorded on the calling thread since the previous call and splits it into frames at the frame scope
+// (a depth 0 scope named frameScope), which ends after all of its children. Frame storage is reused
+// round the ring, so once warm the history doesn't allocate.
+class ProfileHistory
+{
+public:
+	ProfileHistory(unsigned int capacity = 300, const char* frameScope = "frame") :
+		frameName(frameScope),
+		frames(capacity < 1 ? 1 : capacity),
+		cursor(0),
+		next(0),
+		count(0)
+	{
+		pending.reserve(256);
+		incoming.reserve(256);
+	}
+
+	void update()
+	{
+		incoming.clear();
+		Profiler::instance().readThreadEvents(cursor, incoming);
+		for (unsigned int i = 0; i < incoming.size(); i++)
+		{
+			const ProfileEvent& event = incoming[i];
+			if (event.depth != 0 || strcmp(event.name, frameName) != 0)
+			{
+				pending.push_back(event);
+				continue;
+			}
+
+			ProfiledFrame& frame = frames[next];
+			frame.startNs = event.startNs;
+			frame.durationNs = event.durationNs;
+			frame.events.clear();
+			frame.events.push_back(event);
+			for (unsigned int j = 0; j < pending.size(); j++)
+			{
+				if (pending[j].startNs >= event.startNs)
+					frame.events.push_back(pending[j]);
+			}
+			pending.clear();
+			next = (next + 1) % frames.size();
+			if (count < frames.size())
+				count++;
+		}
+	}
+
+	inline unsigned int size() const
+	{
+		return count;
+	}
+
+	inline unsigned int capacity() const
+	{
+		return (unsigned int)frames.size();
+	}
+
+	// frame i, 0 being the oldest kept
+	inline const ProfiledFrame& frame(unsigned int i) const
+	{
+		return frames[(next + frames.size() - count + i) % frames.size()];
+	}
+
+private:
+	const char* frameName;
+	std::vector<ProfiledFrame> frames;
+	std::vector<ProfileEvent> pending;
+	std::vector<ProfileEvent> incoming;
+	uint64_t cursor;
+	unsigned int next;
+	unsigned int count;
+};
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <stdint.h>
+
+#include "allocTracker.h"
+
+// One timed scope, times in nanoseconds since the profiler started.
+struct ProfileEvent {
+	const char* name;   // must outlive the profiler, scope names are string literals
+	int64_t startNs;
+	int64_t durationNs;
+	unsigned int depth; // nesting level on its thread
+	unsigned int allocations; // operator new calls inside the scope, see allocTracker.h
+};
+
+// CPU profiler fed by PROFILE_SCOPE. Every thread records into its own ring buffer, so scopes on
+// different threads never contend; the buffer's mutex is only ever contended while a trace is being
+// written. Recording is off until setEnabled(true), and then a disabled scope costs one relaxed
+// atomic load. Defining SEA_PROFILER_DISABLED compiles the scopes out altogether.
+//
+// writeChromeTrace dumps whatever the buffers hold as chrome://tracing / Perfetto JSON.
+class Profiler
+{
+public:
+	static Profiler& instance()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	inline bool isEnabled() const
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	void setEnabled(bool enable)
+	{
+		enabled.store(enable, std::memory_order_relaxed);
+	}
+
+	inline int64_t now() const
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	// names the calling thread in the trace
+	void setThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		buffer.name = name;
+	}
+
+	// depth bookkeeping for ProfileScope
+	inline unsigned int enterScope()
+	{
+		return threadBuffer().depth++;
+	}
+
+	void leaveScope(const char* name, int64_t startNs, int64_t endNs, unsigned int depth, unsigned int allocations)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+		buffer.depth = depth;
+		ProfileEvent event;
+		event.name = name;
+		event.startNs = startNs;
+		event.durationNs = endNs - startNs;
+		event.depth = depth;
+		event.allocations = allocations;
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		buffer.events[buffer.next] = event;
+		buffer.next = (buffer.next + 1) % buffer.events.size();
+		buffer.recorded++;
+	}
+
+	// drops everything recorded so far
+	void clear()
+	{
+		std::lock_guard<std::mutex> registryLock(registryMutex);
+		for (unsigned int i = 0; i < buffers.size(); i++)
+		{
+			std::lock_guard<std::mutex> lock(buffers[i]->mutex);
+			buffers[i]->next = 0;
+			buffers[i]->recorded = 0;
+		}
+	}
+
+	// calls fn(threadIndex, event) for every buffered event, oldest first per thread
+	template <typename F>
+	void forEachEvent(const F& fn)
+	{
+		std::lock_guard<std::mutex> registryLock(registryMutex);
+		for (unsigned int t = 0; t < buffers.size(); t++)
+		{
+			ThreadBuffer& buffer = *buffers[t];
+			std::lock_guard<std::mutex> lock(buffer.mutex);
+			size_t capacity = buffer.events.size();
+			size_t count = buffer.recorded < capacity ? (size_t)buffer.recorded : capacity;
+			size_t first = (buffer.next + capacity - count) % capacity;
+			for (size_t i = 0; i < count; i++)
+				fn(t, buffer.events[(first + i) % capacity]);
+		}
+	}
+
+	// appends the calling thread's events recorded since cursor to out and moves cursor past them.
+	// Events overwritten in the meantime are lost.
+	void readThreadEvents(uint64_t& cursor, std::vector<ProfileEvent>& out)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		size_t capacity = buffer.events.size();
+		if (cursor > buffer.recorded)
+			cursor = 0; // cleared since
+		if (buffer.recorded - cursor > capacity)
+			cursor = buffer.recorded - capacity;
+		size_t first = (buffer.next + capacity - (size_t)(buffer.recorded - cursor)) % capacity;
+		for (size_t i = 0; cursor < buffer.recorded; i++, cursor++)
+			out.push_back(buffer.events[(first + i) % capacity]);
+	}
+
+	bool writeChromeTrace(const std::string& path)
+	{
+		std::ofstream file(path.c_str());
+		if (!file)
+		{
+			std::cout << "ERROR::PROFILER::FILE_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		file << "{\"traceEvents\":[";
+		bool first = true;
+		{
+			std::lock_guard<std::mutex> registryLock(registryMutex);
+			for (unsigned int t = 0; t < buffers.size(); t++)
+			{
+				std::lock_guard<std::mutex> lock(buffers[t]->mutex);
+				file << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << t
+					<< ",\"args\":{\"name\":\"" << escape(buffers[t]->name) << "\"}}";
+				first = false;
+			}
+		}
+		unsigned int events = 0;
+		forEachEvent([&](unsigned int thread, const ProfileEvent& event)
+		{
+			// microseconds with three decimals keep the nanoseconds
+			file << ",\n{\"ph\":\"X\",\"cat\":\"cpu\",\"name\":\"" << escape(event.name) << "\",\"pid\":1,\"tid\":" << thread
+				<< ",\"ts\":" << event.startNs / 1000 << "." << padded(event.startNs % 1000)
+				<< ",\"dur\":" << event.durationNs / 1000 << "." << padded(event.durationNs % 1000)
+				<< ",\"args\":{\"allocations\":" << event.allocations << "}}";
+			events++;
+		});
+		file << "\n]}\n";
+		std::cout << "Profiler: wrote " << events << " events to " << path << std::endl;
+		return true;
+	}
+
+private:
+	struct ThreadBuffer {
+		std::mutex mutex;
+		std::vector<ProfileEvent> events;
+		size_t next;
+		uint64_t recorded;
+		unsigned int depth;
+		std::string name;
+	};
+
+	std::atomic<bool> enabled;
+	std::chrono::steady_clock::time_point origin;
+	std::mutex registryMutex;
+	// owned here rather than by the threads, so events outlive the thread that recorded them
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	size_t eventsPerThread;
+
+	Profiler() :
+		enabled(false),
+		origin(std::chrono::steady_clock::now()),
+		eventsPerThread(1 << 16)
+	{}
+
+	ThreadBuffer& threadBuffer()
+	{
+		static thread_local ThreadBuffer* buffer = NULL;
+		if (!buffer)
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+			buffer = buffers.back().get();
+			buffer->events.resize(eventsPerThread);
+			buffer->next = 0;
+			buffer->recorded = 0;
+			buffer->depth = 0;
+			buffer->name = buffers.size() == 1 ? "main" : "thread " + std::to_string(buffers.size() - 1);
+		}
+		return *buffer;
+	}
+
+	static std::string escape(const std::string& text)
+	{
+		std::string escaped;
+		for (unsigned int i = 0; i < text.size(); i++)
+		{
+			if (text[i] == '"' || text[i] == '\\')
+				escaped += '\\';
+			escaped += text[i];
+		}
+		return escaped;
+	}
+
+	static std::string padded(int64_t value)
+	{
+		std::string digits = std::to_string(value);
+		return std::string(3 - digits.size(), '0') + digits;
+	}
+};
+
+// times its own lifetime while the profiler is enabled
+class ProfileScope
+{
+public:
+	ProfileScope(const char* scopeName) :
+		name(scopeName),
+		active(Profiler::instance().isEnabled())
+	{
+		if (active)
+		{
+			depth = Profiler::instance().enterScope();
+			startAllocations = AllocTracker::threadAllocations();
+			start = Profiler::instance().now();
+		}
+	}
+
+	~ProfileScope()
+	{
+		end();
+	}
+
+	// closes the scope early, for ranges that don't line up with a block
+	void end()
+	{
+		if (active)
+			Profiler::instance().leaveScope(name, start, Profiler::instance().now(), depth,
+				(unsigned int)(AllocTracker::threadAllocations() - startAllocations));
+		active = false;
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* name;
+	bool active;
+	unsigned int depth;
+	int64_t start;
+	uint64_t startAllocations;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// PROFILE_SCOPE times the rest of the enclosing block, PROFILE_BEGIN(id, name) / PROFILE_END(id) a
+// range within it
+#ifdef SEA_PROFILER_DISABLED
+#define PROFILE_SCOPE(name)
+#define PROFILE_BEGIN(id, name)
+#define PROFILE_END(id)
+#else
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_BEGIN(id, name) ProfileScope profileRange_##id(name)
+#define PROFILE_END(id) profileRange_##id.end()
+#endif
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <stdint.h>
+#include <stdio.h>
+
+// Identity of a linked program: where its binary is cached and what it was built from.
+struct ProgramKey {
+    std::string path;   // cache file, one per combination of shader files and defines
+    uint64_t hash;      // sources, defines and driver; a cached binary with another hash is stale
+};
+
+// Disk cache of linked programs (glGetProgramBinary / glProgramBinary), so a launch doesn't have to
+// compile and link every shader again. Each program is stored next to its vertex shader, keyed by its
+// sources, its defines and the driver's vendor, renderer and version strings: editing a shader or
+// updating the driver makes the cached binary stale and the program is compiled and cached again.
+// A binary the driver refuses is treated the same way.
+class ProgramCache
+{
+public:
+    static ProgramCache& instance()
+    {
+        static ProgramCache cache;
+        return cache;
+    }
+
+    void setEnabled(bool value)
+    {
+        enabled = value;
+    }
+
+    bool isEnabled() const
+    {
+        return enabled && supported();
+    }
+
+    ProgramKey key(const char* vertexPath, const char* fragmentPath, const std::string& vertexCode, const std::string& fragmentCode, const std::string& defines)
+    {
+        uint64_t name = hashString(hashString(hashString(offsetBasis, vertexPath), fragmentPath), defines);
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%08x.program", (unsigned int)(name ^ (name >> 32)));
+
+        ProgramKey programKey;
+        programKey.path = std::string(vertexPath) + suffix;
+        programKey.hash = hashString(hashString(hashString(driverHash(), vertexCode), fragmentCode), defines);
+        return programKey;
+    }
+
+    // creates the program from its cached binary, 0 on a miss
+    GLuint load(const ProgramKey& programKey)
+    {
+        if (!isEnabled())
+        {
+            misses++;
+            return 0;
+        }
+        std::ifstream file(programKey.path.c_str(), std::ios::binary);
+        if (!file)
+        {
+            misses++;
+            return 0;
+        }
+        uint32_t header[4];
+        uint64_t hash = 0;
+        file.read((char*)header, sizeof(header));
+        file.read((char*)&hash, sizeof(hash));
+        if (!file || header[0] != magic || header[1] != version || hash != programKey.hash || header[3] == 0)
+        {
+            misses++;
+            return 0;
+        }
+        std::vector<char> binary(header[3]);
+        file.read(binary.data(), binary.size());
+        if (!file)
+        {
+            std::cout << "ERROR::PROGRAM_CACHE::TRUNCATED " << programKey.path << std::endl;
+            misses++;
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, (GLenum)header[2], binary.data(), (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            // the driver can reject binaries it wrote itself, after an update it didn't report in its version string
+            glDeleteProgram(program);
+            misses++;
+            return 0;
+        }
+        hits++;
+        return program;
+    }
+
+    // call before linking a program that will be stored
+    void prepare(GLuint program) const
+    {
+        if (isEnabled())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // writes the binary of a freshly linked program
+    void store(const ProgramKey& programKey, GLuint program) const
+    {
+        if (!isEnabled())
+            return;
+        GLint linked = GL_FALSE, length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!linked || length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::ofstream file(programKey.path.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "ERROR::PROGRAM_CACHE::NOT_WRITTEN " << programKey.path << std::endl;
+            return;
+        }
+        uint32_t header[4] = { magic, version, (uint32_t)format, (uint32_t)length };
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)&programKey.hash, sizeof(programKey.hash));
+        file.write(binary.data(), length);
+    }
+
+    unsigned int getHits() const
+    {
+        return hits;
+    }
+
+    unsigned int getMisses() const
+    {
+        return misses;
+    }
+
+    // time spent creating programs, from a binary or from source
+    void addBuildTime(double ms)
+    {
+        buildMs += ms;
+    }
+
+    double getBuildMs() const
+    {
+        return buildMs;
+    }
+
+private:
+    static const uint32_t magic = 0x47525053; // "SPRG"
+    static const uint32_t version = 1;
+    static const uint64_t offsetBasis = 14695981039346656037ull;
+
+    bool enabled;
+    mutable GLint formats;
+    uint64_t driver;
+    unsigned int hits;
+    unsigned int misses;
+    double buildMs;
+
+    ProgramCache() :
+        enabled(true),
+        formats(-1),
+        driver(0),
+        hits(0),
+        misses(0),
+        buildMs(0.0)
+    {}
+
+    // needs a current context, so it's asked the first time rather than on construction
+    bool supported() const
+    {
+        if (formats < 0)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    uint64_t driverHash()
+    {
+        if (driver == 0)
+        {
+            const GLenum strings[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+            driver = offsetBasis;
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                const char* text = (const char*)glGetString(strings[i]);
+                driver = hashString(driver, text ? text : "");
+            }
+        }
+        return driver;
+    }
+
+    // FNV-1a, with a separator so ("ab", "c") and ("a", "bc") differ
+    static uint64_t hashString(uint64_t hash, const std::string& text)
+    {
+        for (unsigned int i = 0; i < text.size(); i++)
+        {
+            hash ^= (unsigned char)text[i];
+            hash *= 1099511628211ull;
+        }
+        hash ^= 0xff;
+        hash *= 1099511628211ull;
+        return hash;
+    }
+};
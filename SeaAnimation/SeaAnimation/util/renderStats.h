@@ -0,0 +1,52 @@
+#pragma once
+
+// work submitted to GL during one frame
+struct RenderCounters {
+	unsigned int drawCalls;
+	unsigned int triangles;
+	unsigned int uniformUploads;
+};
+
+// Per frame GL submission counters. Draw calls and uniform uploads count themselves, so the counters
+// are plain integers bumped on the GL thread; beginFrame keeps the finished frame for display.
+class RenderStats
+{
+public:
+	static RenderStats& instance()
+	{
+		static RenderStats stats;
+		return stats;
+	}
+
+	void beginFrame()
+	{
+		last = current;
+		current = RenderCounters();
+	}
+
+	inline void draw(unsigned int triangles)
+	{
+		current.drawCalls++;
+		current.triangles += triangles;
+	}
+
+	inline void uniformUpload()
+	{
+		current.uniformUploads++;
+	}
+
+	// counters of the last complete frame
+	inline const RenderCounters& getLastFrame() const
+	{
+		return last;
+	}
+
+private:
+	RenderCounters current;
+	RenderCounters last;
+
+	RenderStats() :
+		current(),
+		last()
+	{}
+};
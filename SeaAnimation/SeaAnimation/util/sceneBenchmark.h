@@ -0,0 +1,255 @@
+#pragma once
+
+#include "performanceMonitor.h"
+#include "gpuTimer.h"
+#include "renderStats.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+// Scripted run of the scene for --benchmark: every Menu configuration preset, first from the global
+// camera and then from the ship, each a segment of warm-up frames followed by measured ones. Simulation
+// time advances by a fixed step per frame, so every run renders the same frames whatever the frame
+// rate; the camera path through a segment is a function of the frame within it.
+//
+// nextFrame is called at the top of each frame, once the monitor, timer and counters have closed the
+// previous one, and records that frame if it was measured. GPU times are recorded as the timer reads
+// them back rather than once per frame: a pass whose query hasn't come back keeps its last result,
+// and recording that again would count one measurement several times.
+class SceneBenchmark
+{
+public:
+	// framePass: the GpuTimer pass around the whole frame, for the GPU frame time
+	SceneBenchmark(unsigned int framePass, unsigned int warmup = 120, unsigned int measured = 600, float step = 1.0f / 60.0f) :
+		gpuFramePass(framePass),
+		warmupFrames(warmup),
+		measuredFrames(measured > 0 ? measured : 1),
+		timeStep(step),
+		frame(0),
+		current(0),
+		previousMeasured(false),
+		previousSegment(0)
+	{
+		for (unsigned int p = 0; p < FrameSample::maxStages; p++)
+			passSamples[p] = 0;
+		for (unsigned int view = 0; view < 2; view++)
+		{
+			for (unsigned int preset = 1; preset <= 4; preset++)
+			{
+				Segment segment;
+				segment.preset = preset;
+				segment.shipView = view == 1;
+				segment.drawCalls = segment.triangles = segment.uniformUploads = segment.allocations = 0;
+				segments.push_back(segment);
+				// recording a frame mustn't allocate, it would count against the frame
+				segments.back().cpuMs.reserve(measuredFrames);
+				segments.back().gpuMs.reserve(measuredFrames);
+				segments.back().stageMs.reserve(measuredFrames * FrameSample::maxStages);
+				for (unsigned int p = 0; p < FrameSample::maxStages; p++)
+					segments.back().passMs[p].reserve(measuredFrames);
+			}
+		}
+	}
+
+	// moves on to the next frame, false once every segment is done
+	bool nextFrame(const PerformanceMonitor& monitor, const GpuTimer& gpuTimer, const RenderCounters& counters, unsigned int allocations)
+	{
+		if (previousMeasured)
+			record(segments[previousSegment], monitor, gpuTimer, counters, allocations);
+		if (frame == segments.size() * segmentFrames())
+			return false;
+		previousSegment = frame / segmentFrames();
+		previousMeasured = frame % segmentFrames() >= warmupFrames;
+		current = frame++;
+		return true;
+	}
+
+	// the frame set up by the last nextFrame
+	inline unsigned int getPreset() const
+	{
+		return segments[current / segmentFrames()].preset;
+	}
+
+	inline bool isShipView() const
+	{
+		return segments[current / segmentFrames()].shipView;
+	}
+
+	// first frame of a segment, when its preset and view get applied
+	inline bool isSegmentStart() const
+	{
+		return current % segmentFrames() == 0;
+	}
+
+	// position along the segment's camera path, 0 to 1
+	inline float getPathPosition() const
+	{
+		return (float)(current % segmentFrames()) / (float)segmentFrames();
+	}
+
+	inline float getTime() const
+	{
+		return current * timeStep;
+	}
+
+	bool writeJson(const std::string& path, const PerformanceMonitor& monitor, const GpuTimer& gpuTimer)
+	{
+		std::ofstream file(path.c_str());
+		if (!file)
+		{
+			std::cout << "ERROR::BENCHMARK::FILE_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		const std::vector<std::string>& stages = monitor.getStageNames();
+		std::vector<std::string> passes;
+		for (unsigned int p = 0; p < gpuTimer.getPassCount() && p < FrameSample::maxStages; p++)
+			passes.push_back(gpuTimer.getName(p));
+		file << std::fixed << std::setprecision(4);
+		file << "{\n  \"warmup_frames\": " << warmupFrames << ",\n  \"measured_frames\": " << measuredFrames
+			<< ",\n  \"time_step\": " << timeStep << ",\n  \"segments\": [";
+		for (unsigned int i = 0; i < segments.size(); i++)
+		{
+			Segment& segment = segments[i];
+			unsigned int frames = (unsigned int)segment.cpuMs.size();
+			file << (i ? "," : "") << "\n    {\n      \"preset\": " << segment.preset
+				<< ",\n      \"view\": \"" << (segment.shipView ? "ship" : "global") << "\""
+				<< ",\n      \"frames\": " << frames;
+			std::vector<float> sorted = segment.cpuMs;
+			file << ",\n      \"cpu\": ";
+			PerformanceMonitor::writeStatsJson(file, PerformanceMonitor::computeStats(sorted));
+			sorted = segment.gpuMs;
+			file << ",\n      \"gpu\": ";
+			PerformanceMonitor::writeStatsJson(file, PerformanceMonitor::computeStats(sorted));
+			// every frame, in order, for comparing runs (BenchCompare)
+			writeSamples(file, "cpu_ms_samples", segment.cpuMs);
+			writeSamples(file, "gpu_ms_samples", segment.gpuMs);
+			writeColumns(file, "cpu_stage_samples", segment.stageMs, stages);
+			writeLists(file, "gpu_pass_samples", segment.passMs, passes);
+			file << ",\n      \"cpu_stages_ms\": {";
+			for (unsigned int s = 0; s < stages.size(); s++)
+				file << (s ? ", " : " ") << "\"" << stages[s] << "\": " << mean(segment.stageMs, s, (unsigned int)stages.size());
+			file << " },\n      \"gpu_passes_ms\": {";
+			for (unsigned int p = 0; p < passes.size(); p++)
+				file << (p ? ", " : " ") << "\"" << passes[p] << "\": " << mean(segment.passMs[p], 0, 1);
+			double perFrame = frames > 0 ? 1.0 / frames : 0.0;
+			file << " },\n      \"per_frame\": { \"draw_calls\": " << segment.drawCalls * perFrame
+				<< ", \"triangles\": " << segment.triangles * perFrame
+				<< ", \"uniform_uploads\": " << segment.uniformUploads * perFrame
+				<< ", \"allocations\": " << segment.allocations * perFrame << " }\n    }";
+		}
+		file << "\n  ]\n}\n";
+		std::cout << "Benchmark report written to " << path << std::endl;
+		return true;
+	}
+
+private:
+	struct Segment {
+		unsigned int preset;
+		bool shipView;
+		std::vector<float> cpuMs;
+		std::vector<float> gpuMs;
+		// stage times of every measured frame, one row per frame
+		std::vector<float> stageMs;
+		// every result read back for each pass during the measured frames
+		std::vector<float> passMs[FrameSample::maxStages];
+		// sums over the measured frames
+		unsigned long long drawCalls;
+		unsigned long long triangles;
+		unsigned long long uniformUploads;
+		unsigned long long allocations;
+	};
+
+	unsigned int gpuFramePass;
+	unsigned int warmupFrames;
+	unsigned int measuredFrames;
+	float timeStep;
+	std::vector<Segment> segments;
+	unsigned int frame;
+	unsigned int current;
+	bool previousMeasured;
+	unsigned int previousSegment;
+	std::vector<FrameSample> latest;
+	// GpuTimer::getSamples of each pass when it was last recorded
+	unsigned int passSamples[FrameSample::maxStages];
+
+	inline unsigned int segmentFrames() const
+	{
+		return warmupFrames + measuredFrames;
+	}
+
+	void record(Segment& segment, const PerformanceMonitor& monitor, const GpuTimer& gpuTimer, const RenderCounters& counters, unsigned int allocations)
+	{
+		monitor.snapshot(latest, 1);
+		if (latest.empty())
+			return;
+		const FrameSample& sample = latest[0];
+		segment.cpuMs.push_back(sample.cpuMs);
+		for (unsigned int s = 0; s < monitor.getStageNames().size(); s++)
+			segment.stageMs.push_back(sample.stageMs[s]);
+		// GPU times are a few frames late, the timer never waits for its queries; only new results count
+		for (unsigned int p = 0; p < gpuTimer.getPassCount() && p < FrameSample::maxStages; p++)
+		{
+			if (gpuTimer.getSamples(p) == passSamples[p])
+				continue;
+			passSamples[p] = gpuTimer.getSamples(p);
+			segment.passMs[p].push_back(gpuTimer.getLastMs(p));
+			if (p == gpuFramePass)
+				segment.gpuMs.push_back(gpuTimer.getLastMs(p));
+		}
+		segment.drawCalls += counters.drawCalls;
+		segment.triangles += counters.triangles;
+		segment.uniformUploads += counters.uniformUploads;
+		segment.allocations += allocations;
+	}
+
+	static void writeSamples(std::ostream& file, const char* name, const std::vector<float>& samples)
+	{
+		file << ",\n      \"" << name << "\": [";
+		for (unsigned int i = 0; i < samples.size(); i++)
+			file << (i ? ", " : "") << samples[i];
+		file << "]";
+	}
+
+	// one array per column of the rows, by the column's name
+	static void writeColumns(std::ostream& file, const char* name, const std::vector<float>& rows, const std::vector<std::string>& columns)
+	{
+		file << ",\n      \"" << name << "\": {";
+		unsigned int count = columns.empty() ? 0 : (unsigned int)(rows.size() / columns.size());
+		for (unsigned int c = 0; c < columns.size(); c++)
+		{
+			file << (c ? ",\n        \"" : "\n        \"") << columns[c] << "\": [";
+			for (unsigned int i = 0; i < count; i++)
+				file << (i ? ", " : "") << rows[i * columns.size() + c];
+			file << "]";
+		}
+		file << (columns.empty() ? "}" : "\n      }");
+	}
+
+	// one array per list, by the list's name
+	static void writeLists(std::ostream& file, const char* name, const std::vector<float>* lists, const std::vector<std::string>& names)
+	{
+		file << ",\n      \"" << name << "\": {";
+		for (unsigned int l = 0; l < names.size(); l++)
+		{
+			file << (l ? ",\n        \"" : "\n        \"") << names[l] << "\": [";
+			for (unsigned int i = 0; i < lists[l].size(); i++)
+				file << (i ? ", " : "") << lists[l][i];
+			file << "]";
+		}
+		file << (names.empty() ? "}" : "\n      }");
+	}
+
+	static double mean(const std::vector<float>& rows, unsigned int column, unsigned int columns)
+	{
+		if (columns == 0 || rows.size() < columns)
+			return 0.0;
+		double sum = 0.0;
+		unsigned int count = (unsigned int)(rows.size() / columns);
+		for (unsigned int i = 0; i < count; i++)
+			sum += rows[i * columns + column];
+		return sum / count;
+	}
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "threadPool.h"
+
+#include <string>
+#include <vector>
+
+// Node hierarchy of a model stored as flat arrays (structure of arrays). Nodes are kept in breadth
+// first order, so every parent comes before its children and all nodes of the same depth are
+// contiguous: world transforms are resolved in one linear pass, or level by level in parallel.
+class SceneHierarchy
+{
+public:
+    // topology
+    std::vector<int> parent;            // -1 for the root
+    std::vector<unsigned int> levelStart; // first node of each depth, plus one past the last node
+    // local transform, editable to animate sub-parts
+    std::vector<glm::vec3> translation;
+    std::vector<glm::quat> rotation;
+    std::vector<glm::vec3> scale;
+    // result of updateWorldTransforms
+    std::vector<glm::mat4> world;
+    // meshes of each node: nodeMeshes[meshStart[i] .. meshStart[i] + meshCount[i])
+    std::vector<unsigned int> meshStart;
+    std::vector<unsigned int> meshCount;
+    std::vector<unsigned int> nodeMeshes;
+    std::vector<std::string> name;
+
+    // nodes at least this numerous in a level are updated on the thread pool
+    unsigned int parallelThreshold;
+
+    SceneHierarchy() : parallelThreshold(2048) {}
+
+    inline unsigned int size() const
+    {
+        return (unsigned int)parent.size();
+    }
+
+    // nodes must be added in breadth first order: parents before children, depth by depth
+    unsigned int addNode(int parentIndex, const std::string& nodeName, glm::vec3 t, glm::quat r, glm::vec3 s)
+    {
+        unsigned int index = size();
+        unsigned int depth = parentIndex < 0 ? 0 : nodeDepth[parentIndex] + 1;
+        // levelStart ends with one past the last node, moved along as nodes are added
+        if (levelStart.empty())
+            levelStart.push_back(0);
+        if (depth + 1 >= levelStart.size())
+            levelStart.push_back(index);
+        levelStart.back() = index + 1;
+        parent.push_back(parentIndex);
+        nodeDepth.push_back(depth);
+        name.push_back(nodeName);
+        translation.push_back(t);
+        rotation.push_back(r);
+        scale.push_back(s);
+        world.push_back(glm::mat4(1.0f));
+        meshStart.push_back((unsigned int)nodeMeshes.size());
+        meshCount.push_back(0);
+        return index;
+    }
+
+    // meshes can only be added to the most recently added node
+    void addMesh(unsigned int mesh)
+    {
+        nodeMeshes.push_back(mesh);
+        meshCount.back()++;
+    }
+
+    // index of the first node with the given name, -1 if there is none
+    int findNode(const std::string& nodeName) const
+    {
+        for (unsigned int i = 0; i < name.size(); i++)
+        {
+            if (name[i] == nodeName)
+                return (int)i;
+        }
+        return -1;
+    }
+
+    glm::mat4 localMatrix(unsigned int i) const
+    {
+        glm::mat4 m = glm::mat4_cast(rotation[i]);
+        m[0] *= scale[i].x;
+        m[1] *= scale[i].y;
+        m[2] *= scale[i].z;
+        m[3] = glm::vec4(translation[i], 1.0f);
+        return m;
+    }
+
+    void updateWorldTransforms(const glm::mat4& rootTransform)
+    {
+        unsigned int levels = levelStart.empty() ? 0 : (unsigned int)levelStart.size() - 1;
+        for (unsigned int level = 0; level < levels; level++)
+        {
+            unsigned int first = levelStart[level];
+            unsigned int last = levelStart[level + 1];
+            unsigned int count = last - first;
+            if (count >= parallelThreshold)
+            {
+                // a level only reads the world matrices of the previous one
+                const unsigned int batch = 256;
+                ThreadPool::shared().parallelFor((count + batch - 1) / batch, [&](unsigned int b)
+                {
+                    unsigned int end = first + (b + 1) * batch < last ? first + (b + 1) * batch : last;
+                    for (unsigned int i = first + b * batch; i < end; i++)
+                        updateNode(i, rootTransform);
+                });
+            }
+            else
+            {
+                for (unsigned int i = first; i < last; i++)
+                    updateNode(i, rootTransform);
+            }
+        }
+    }
+
+private:
+    std::vector<unsigned int> nodeDepth;
+
+    inline void updateNode(unsigned int i, const glm::mat4& rootTransform)
+    {
+        const glm::mat4& parentWorld = parent[i] < 0 ? rootTransform : world[parent[i]];
+        world[i] = parentWorld * localMatrix(i);
+    }
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "seaMesh.h"
+#include "../shader/shader.h"
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+// What the sea benchmarks draw and compare with: a createSeaMesh grid on the GPU, an off-screen target
+// to read images back from, the light and material they are lit with and the error between two images.
+
+// createSeaMesh grid of size x size vertices in a VAO of its own, for drawing with the sea shaders
+class SeaGrid
+{
+public:
+	SeaGrid(unsigned int size, glm::vec3 initPos, glm::vec3 finalPos, float sizeUV) :
+		size(size),
+		indexCount((size - 1) * (size - 1) * 2 * 3)
+	{
+		float* vertices;
+		unsigned int* indices;
+		createSeaMesh(vertices, indices, size, initPos, finalPos, sizeUV);
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, (size * size) * 5 * sizeof(float), vertices, GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		glBindVertexArray(0);
+		delete[] vertices;
+		delete[] indices;
+	}
+
+	~SeaGrid()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+	}
+
+	SeaGrid(const SeaGrid&) = delete;
+	SeaGrid& operator=(const SeaGrid&) = delete;
+
+	// binds the grid's VAO, for drawing it more than once in a row with drawElements
+	void bind() const
+	{
+		glBindVertexArray(VAO);
+	}
+
+	void drawElements() const
+	{
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+	}
+
+	void draw() const
+	{
+		bind();
+		drawElements();
+	}
+
+	unsigned int getSize() const
+	{
+		return size;
+	}
+
+private:
+	unsigned int VAO, VBO, EBO;
+	unsigned int size;
+	unsigned int indexCount;
+};
+
+// RGBA8 colour and depth-stencil renderbuffers of width x height in a framebuffer, to draw to off
+// screen and read the image back with glReadPixels
+class OffscreenTarget
+{
+public:
+	OffscreenTarget(unsigned int width, unsigned int height) :
+		width(width),
+		height(height)
+	{
+		glGenFramebuffers(1, &FBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glGenRenderbuffers(1, &colorBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+		glGenRenderbuffers(1, &depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::OFFSCREEN_TARGET::FRAMEBUFFER_INCOMPLETE" << std::endl;
+	}
+
+	// deleting the bound framebuffer leaves the default one bound
+	~OffscreenTarget()
+	{
+		glDeleteFramebuffers(1, &FBO);
+		glDeleteRenderbuffers(1, &colorBuffer);
+		glDeleteRenderbuffers(1, &depthBuffer);
+	}
+
+	OffscreenTarget(const OffscreenTarget&) = delete;
+	OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+	// draws to the target from now on, over all of it
+	void bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glViewport(0, 0, width, height);
+	}
+
+	// the colour buffer as RGBA bytes, width * height * 4 of them
+	void readPixels(unsigned char* pixels) const
+	{
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	}
+
+private:
+	unsigned int FBO, colorBuffer, depthBuffer;
+	unsigned int width, height;
+};
+
+// the light and water of the image benchmarks: a low sun so the short waves show in the highlights
+inline void setSeaBenchmarkLighting(const Shader& shader)
+{
+	shader.setVec3("light.direction", glm::normalize(glm::vec3(0.2f, -1.0f, -0.35f)));
+	shader.setVec3("light.ambient", glm::vec3(0.3f));
+	shader.setVec3("light.diffuse", glm::vec3(0.7f));
+	shader.setVec3("light.specular", glm::vec3(1.0f));
+	shader.setVec3("material.color", glm::vec3(0.1f, 0.4f, 0.6f));
+	shader.setVec3("material.ambient", glm::vec3(1.0f));
+	shader.setVec3("material.diffuse", glm::vec3(1.0f));
+	shader.setVec3("material.specular", glm::vec3(0.6f));
+	shader.setFloat("material.shininess", 64.0f);
+}
+
+// Mean difference of the colour channels, in 8 bit levels, between images and their references over
+// the sea's pixels. The sky is cleared to alpha 0 and a pixel counts when it is sea in either image;
+// add takes any number of image pairs and the mean is over all of them.
+class SeaImageError
+{
+public:
+	SeaImageError() :
+		difference(0.0),
+		seaPixels(0)
+	{
+	}
+
+	// RGBA images of pixelCount pixels; the reference may be bytes or averaged floats
+	template <typename T>
+	void add(const unsigned char* image, const T* reference, size_t pixelCount)
+	{
+		for (size_t p = 0; p < pixelCount; p++)
+		{
+			if (image[p * 4 + 3] == 0 && reference[p * 4 + 3] == 0)
+				continue;
+			seaPixels++;
+			for (unsigned int c = 0; c < 3; c++)
+				difference += std::abs((float)image[p * 4 + c] - (float)reference[p * 4 + c]);
+		}
+	}
+
+	float mean() const
+	{
+		return seaPixels > 0 ? (float)(difference / (seaPixels * 3)) : 0.0f;
+	}
+
+private:
+	double difference;
+	size_t seaPixels;
+};
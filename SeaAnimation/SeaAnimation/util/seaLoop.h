@@ -0,0 +1,251 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "../shader/shader.h"
+#include "../shader/computeShader.h"
+
+#include <cmath>
+
+// A looped sea animation baked ahead of time: the displacement and normal of frames evenly spaced over
+// one loop period go into the layers of two array textures, which the sea variants with SEA_BAKED 2
+// play back, blending the two frames around the current time. Per frame the waves then cost two
+// texture fetches per vertex and two per fragment, and nothing is evaluated until the waves change.
+//
+// Deep water waves of wavelength L repeat every sqrt(2 pi L / g) seconds, and a sum of waves only
+// repeats if those periods are commensurate. findPeriod picks a loop period T and shortens or
+// stretches every wavelength a little so each wave fits a whole number of cycles into T; the frames
+// are baked with those wavelengths.
+class SeaLoop
+{
+public:
+    // frames per loop, resolution texels along each side covering origin to origin + extent
+    SeaLoop(unsigned int frames, unsigned int resolution, const glm::vec2& origin, const glm::vec2& extent) :
+        program("shader/seaBake.comp", "#define DISPLACEMENT_FORMAT rgba16f\n#define NORMAL_FORMAT rgba8_snorm\n"),
+        frameCount(frames < minFramesPerCycle ? minFramesPerCycle : frames),
+        size(resolution < 2 ? 2 : resolution),
+        bakeOrigin(origin),
+        bakeExtent(extent),
+        baked(false),
+        lastWaveCount(0),
+        period(1.0f),
+        wavelengthError(0.0f),
+        bakeCount(0)
+    {
+        displacementTexture = createTexture(GL_RGBA16F);
+        normalTexture = createTexture(GL_RGBA8_SNORM);
+    }
+
+    ~SeaLoop()
+    {
+        glDeleteTextures(1, &displacementTexture);
+        glDeleteTextures(1, &normalTexture);
+    }
+
+    SeaLoop(const SeaLoop&) = delete;
+    SeaLoop& operator=(const SeaLoop&) = delete;
+
+    // a frame of a wave cycle is 1 / minFramesPerCycle of it at most, or blending flattens the wave
+    static const unsigned int minFramesPerCycle = 8;
+
+    // The loop period for the first count waves and the waves with their wavelengths moved to fit it,
+    // each doing between 1 and maxCycles cycles per loop. error is the largest relative wavelength
+    // change. Every period making one wave fit exactly is tried, the one changing the others least wins.
+    static float findPeriod(const glm::vec4* waves, unsigned int count, float gravity, unsigned int maxCycles, glm::vec4* quantised, float* error)
+    {
+        float bestPeriod = 1.0f;
+        float bestError = count > 0 ? 1e30f : 0.0f;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            for (unsigned int n = 1; n <= maxCycles; n++)
+            {
+                float candidate = (float)n * wavePeriod(waves[i].w, gravity);
+                float candidateError = 0.0f;
+                for (unsigned int j = 0; j < count; j++)
+                {
+                    float wavelength = wavelengthFor(candidate / cyclesIn(candidate, waves[j].w, gravity, maxCycles), gravity);
+                    candidateError = glm::max(candidateError, std::fabs(wavelength - waves[j].w) / waves[j].w);
+                }
+                if (candidateError < bestError)
+                {
+                    bestError = candidateError;
+                    bestPeriod = candidate;
+                }
+            }
+        }
+        for (unsigned int j = 0; j < count; j++)
+        {
+            float cycles = cyclesIn(bestPeriod, waves[j].w, gravity, maxCycles);
+            quantised[j] = glm::vec4(waves[j].x, waves[j].y, waves[j].z, wavelengthFor(bestPeriod / cycles, gravity));
+        }
+        *error = bestError;
+        return bestPeriod;
+    }
+
+    // bakes every frame of the loop when the waves are not those of the last bake, true if it did
+    bool update(float gravity, const glm::vec4* waves, unsigned int waveCount)
+    {
+        waveCount = waveCount > 3 ? 3 : waveCount;
+        if (baked && gravity == lastGravity && waveCount == lastWaveCount)
+        {
+            bool same = true;
+            for (unsigned int i = 0; i < waveCount; i++)
+                same = same && waves[i] == lastWaves[i];
+            if (same)
+                return false;
+        }
+
+        period = findPeriod(waves, waveCount, gravity, frameCount / minFramesPerCycle, loopWaves, &wavelengthError);
+
+        program.use();
+        program.setVec2("bakeOrigin", bakeOrigin);
+        program.setVec2("bakeExtent", bakeExtent);
+        program.setInt("bakeResolution", (int)size);
+        program.setFloat("gravity", gravity);
+        program.setInt("waveCount", (int)waveCount);
+        if (waveCount > 0)
+            program.setVec4Array("waves", loopWaves, waveCount);
+        unsigned int groups = (size + groupSize - 1) / groupSize;
+        for (unsigned int frame = 0; frame < frameCount; frame++)
+        {
+            program.setFloat("time", period * (float)frame / (float)frameCount);
+            glBindImageTexture(0, displacementTexture, 0, GL_FALSE, (GLint)frame, GL_WRITE_ONLY, GL_RGBA16F);
+            glBindImageTexture(1, normalTexture, 0, GL_FALSE, (GLint)frame, GL_WRITE_ONLY, GL_RGBA8_SNORM);
+            program.dispatch(groups, groups);
+        }
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        baked = true;
+        lastGravity = gravity;
+        lastWaveCount = waveCount;
+        for (unsigned int i = 0; i < waveCount; i++)
+            lastWaves[i] = waves[i];
+        bakeCount++;
+        return true;
+    }
+
+    // time into the loop at time, what the frames at frameAt(time) show
+    float loopTime(float time) const
+    {
+        float t = std::fmod(time, period);
+        return t < 0.0f ? t + period : t;
+    }
+
+    // position in the loop at time, in frames: the shader blends frame floor(f) into the next one
+    float frameAt(float time) const
+    {
+        return glm::min(loopTime(time) / period * (float)frameCount, (float)frameCount - 0.0001f);
+    }
+
+    // one of the waves given to update with the wavelength the loop was baked with, any other wave as it is;
+    // what to evaluate on the CPU to stay on the water drawn at loopTime
+    glm::vec4 loopWave(const glm::vec4& wave) const
+    {
+        for (unsigned int i = 0; i < lastWaveCount; i++)
+        {
+            if (wave == lastWaves[i])
+                return loopWaves[i];
+        }
+        return wave;
+    }
+
+    // the uniforms a SEA_BAKED 2 variant needs besides the textures and loopFrame, once per variant
+    void setUniforms(const Shader& shader, int displacementUnit, int normalUnit) const
+    {
+        shader.setInt("displacementMap", displacementUnit);
+        shader.setInt("normalMap", normalUnit);
+        shader.setVec2("bakeOrigin", bakeOrigin);
+        shader.setVec2("bakeExtent", bakeExtent);
+        shader.setFloat("bakeResolution", (float)size);
+        shader.setFloat("loopFrames", (float)frameCount);
+    }
+
+    // binds the textures to the units given to setUniforms
+    void bindTextures(int displacementUnit, int normalUnit) const
+    {
+        glActiveTexture(GL_TEXTURE0 + displacementUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, displacementTexture);
+        glActiveTexture(GL_TEXTURE0 + normalUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, normalTexture);
+    }
+
+    float getPeriod() const
+    {
+        return period;
+    }
+
+    // largest relative change of a wavelength made to fit the loop
+    float getWavelengthError() const
+    {
+        return wavelengthError;
+    }
+
+    unsigned int getFrameCount() const
+    {
+        return frameCount;
+    }
+
+    unsigned int getBakeCount() const
+    {
+        return bakeCount;
+    }
+
+    size_t textureBytes() const
+    {
+        // 8 bytes per displacement texel, 4 per normal
+        return (size_t)size * size * frameCount * (8 + 4);
+    }
+
+private:
+    static const unsigned int groupSize = 8; // local_size of seaBake.comp
+
+    ComputeShader program;
+    unsigned int frameCount;
+    unsigned int size;
+    glm::vec2 bakeOrigin;
+    glm::vec2 bakeExtent;
+    unsigned int displacementTexture;
+    unsigned int normalTexture;
+
+    bool baked;
+    float lastGravity;
+    unsigned int lastWaveCount;
+    glm::vec4 lastWaves[3];
+    glm::vec4 loopWaves[3];
+    float period;
+    float wavelengthError;
+    unsigned int bakeCount;
+
+    // seconds per cycle of a deep water wave, c = sqrt(g / k) as in seaShader.vs
+    static float wavePeriod(float wavelength, float gravity)
+    {
+        return std::sqrt(2.0f * glm::pi<float>() * wavelength / gravity);
+    }
+
+    static float wavelengthFor(float wavePeriod, float gravity)
+    {
+        return gravity * wavePeriod * wavePeriod / (2.0f * glm::pi<float>());
+    }
+
+    // whole cycles of a wave closest to fitting loopPeriod
+    static float cyclesIn(float loopPeriod, float wavelength, float gravity, unsigned int maxCycles)
+    {
+        float cycles = std::floor(loopPeriod / wavePeriod(wavelength, gravity) + 0.5f);
+        return glm::clamp(cycles, 1.0f, (float)maxCycles);
+    }
+
+    unsigned int createTexture(GLenum format) const
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, format, (GLsizei)size, (GLsizei)size, (GLsizei)frameCount);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+};
@@ -0,0 +1,66 @@
+#ifndef SEA_MESH_H
+#define SEA_MESH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Flat grid of N x N vertices between initPos and finalPos, 5 floats per vertex (position, uv), two
+// triangles per cell. The arrays are allocated with new[] and owned by the caller.
+inline void createSeaMesh(float*& vertices, unsigned int*& indices, unsigned int N, glm::vec3 initPos, glm::vec3 finalPos, float sizeUV) {
+    int vertexSize = 5;
+    int indexSize = 3;
+    float xGap = (finalPos.x - initPos.x) / ((float)N - 1.0f);
+    float yGap = (finalPos.y - initPos.y) / ((float)N - 1.0f);
+    vertices = new float[N * N * vertexSize];
+    indices = new unsigned int[(N - 1) * (N - 1) * 2 * indexSize];
+
+    for (unsigned int j = 0; j < N; j++) {
+        for (unsigned int i = 0; i < N; i++) {
+            float tempv[] = {
+                initPos.x + i * xGap, initPos.y + j * yGap, initPos.z,
+                0.0f + ((float)i / (float)N) * sizeUV, sizeUV - ((float)j / (float)N) * sizeUV };
+            std::copy(tempv, tempv + (1 * vertexSize), (vertices + (j * N + i) * vertexSize));
+
+            if ((j < N - 1) && (i < N - 1)) {
+                unsigned int tempi[] = {
+                    (j * N + i), (j * N + (i + 1)), ((j + 1) * N + (i + 1)),
+                    ((j + 1) * N + (i + 1)), ((j + 1) * N + (i + 0)), ((j + 0) * N + (i + 0)) };
+                std::copy(tempi, tempi + (2 * indexSize), (indices + (j * (N - 1) + i) * 2 * indexSize));
+            }
+        }
+    }
+}
+
+// Vertices a side of a createSeaMesh grid extent wide for samplesPerWavelength vertices along the
+// shortest wave it displaces.
+inline unsigned int seaGridSize(float extent, float shortestWavelength, float samplesPerWavelength) {
+    return (unsigned int)std::ceil(extent * samplesPerWavelength / shortestWavelength) + 1;
+}
+
+// Grid of patches x patches quads between initPos and finalPos for GL_PATCHES with 4 vertices, the
+// corners of each quad counter clockwise from its lowest x and y; same vertex layout as createSeaMesh.
+inline void createSeaPatches(float*& vertices, unsigned int*& indices, unsigned int patches, glm::vec3 initPos, glm::vec3 finalPos, float sizeUV) {
+    unsigned int N = patches + 1;
+    int vertexSize = 5;
+    float xGap = (finalPos.x - initPos.x) / (float)patches;
+    float yGap = (finalPos.y - initPos.y) / (float)patches;
+    vertices = new float[N * N * vertexSize];
+    indices = new unsigned int[patches * patches * 4];
+
+    for (unsigned int j = 0; j < N; j++) {
+        for (unsigned int i = 0; i < N; i++) {
+            float tempv[] = {
+                initPos.x + i * xGap, initPos.y + j * yGap, initPos.z,
+                0.0f + ((float)i / (float)patches) * sizeUV, sizeUV - ((float)j / (float)patches) * sizeUV };
+            std::copy(tempv, tempv + vertexSize, (vertices + (j * N + i) * vertexSize));
+
+            if ((j < patches) && (i < patches)) {
+                unsigned int tempi[] = { (j * N + i), (j * N + (i + 1)), ((j + 1) * N + (i + 1)), ((j + 1) * N + i) };
+                std::copy(tempi, tempi + 4, (indices + (j * patches + i) * 4));
+            }
+        }
+    }
+}
+#endif
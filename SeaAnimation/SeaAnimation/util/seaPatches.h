@@ -0,0 +1,105 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "seaMesh.h"
+#include "../shader/shader.h"
+
+// The sea as a coarse grid of patches for the tessellation path (shader/seaTess.*): the GPU splits
+// each patch as finely as the waves need at its distance from the camera and displaces the vertices
+// it makes, so geometry is dense near the camera and sparse far away instead of uniform like the grid
+// of createSeaMesh.
+class SeaPatches
+{
+public:
+    // screen error a segment may have, and the shortest segment, both in pixels
+    float pixelError;
+    float minSegmentPixels;
+
+    SeaPatches(unsigned int patches, glm::vec3 initPos, glm::vec3 finalPos, float sizeUV) :
+        pixelError(0.5f),
+        minSegmentPixels(4.0f),
+        patchesPerSide(patches),
+        patchCount(patches * patches),
+        maxLevel(64.0f)
+    {
+        float* vertices;
+        unsigned int* indices;
+        createSeaPatches(vertices, indices, patches, initPos, finalPos, sizeUV);
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, (patches + 1) * (patches + 1) * 5 * sizeof(float), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, patchCount * 4 * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+        // position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        // texture coord attribute
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+        delete[] vertices;
+        delete[] indices;
+
+        GLint level = 64;
+        glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &level);
+        maxLevel = (float)level;
+    }
+
+    ~SeaPatches()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+    SeaPatches(const SeaPatches&) = delete;
+    SeaPatches& operator=(const SeaPatches&) = delete;
+
+    // the tessellation uniforms for the first waveCount waves; projScale is Model::projectionScale
+    void setUniforms(const Shader& shader, const glm::vec4* waves, unsigned int waveCount, float projScale) const
+    {
+        // a wave of steepness s and wavenumber k has amplitude s / k and curvature s * k
+        float curvature = 0.0f, amplitude = 0.0f;
+        for (unsigned int i = 0; i < waveCount; i++)
+        {
+            float k = 2.0f * glm::pi<float>() / waves[i].w;
+            curvature += waves[i].z * k;
+            amplitude += waves[i].z / k;
+        }
+        shader.setFloat("projScale", projScale);
+        shader.setFloat("pixelError", pixelError);
+        shader.setFloat("minSegmentPixels", minSegmentPixels);
+        shader.setFloat("waveCurvature", curvature);
+        shader.setFloat("waveAmplitude", amplitude);
+        shader.setFloat("maxTessLevel", maxLevel);
+    }
+
+    void draw() const
+    {
+        glPatchParameteri(GL_PATCH_VERTICES, 4);
+        glBindVertexArray(VAO);
+        glDrawElements(GL_PATCHES, patchCount * 4, GL_UNSIGNED_INT, 0);
+    }
+
+    unsigned int getPatchCount() const
+    {
+        return patchCount;
+    }
+
+    size_t bufferBytes() const
+    {
+        return (size_t)(patchesPerSide + 1) * (patchesPerSide + 1) * 5 * sizeof(float) + (size_t)patchCount * 4 * sizeof(unsigned int);
+    }
+
+private:
+    unsigned int VAO, VBO, EBO;
+    unsigned int patchesPerSide;
+    unsigned int patchCount;
+    float maxLevel;
+};
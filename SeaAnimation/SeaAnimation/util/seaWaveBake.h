@@ -0,0 +1,147 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "../shader/shader.h"
+#include "../shader/computeShader.h"
+
+// Bakes the sea waves into two textures once per frame with a compute pass (shader/seaBake.comp):
+// the displacement of every grid point into an rgba32f texture and the surface normal into an rgba16f
+// one, at a resolution chosen independently of the mesh. The sea variants with SEA_BAKED then fetch
+// the displacement per vertex and the normal per fragment instead of evaluating every wave for every
+// vertex, so the wave cost follows the bake resolution rather than the vertex count and the view.
+//
+// A frame whose waves and time are those of the last bake, e.g. with the simulation paused, reuses it.
+class SeaWaveBake
+{
+public:
+    // resolution texels along each side, covering the rectangle from origin to origin + extent
+    SeaWaveBake(unsigned int resolution, const glm::vec2& origin, const glm::vec2& extent) :
+        program("shader/seaBake.comp"),
+        size(resolution < 2 ? 2 : resolution),
+        bakeOrigin(origin),
+        bakeExtent(extent),
+        displacementTexture(0),
+        normalTexture(0),
+        baked(false),
+        bakeCount(0)
+    {
+        displacementTexture = createTexture(GL_RGBA32F);
+        normalTexture = createTexture(GL_RGBA16F);
+    }
+
+    ~SeaWaveBake()
+    {
+        glDeleteTextures(1, &displacementTexture);
+        glDeleteTextures(1, &normalTexture);
+    }
+
+    SeaWaveBake(const SeaWaveBake&) = delete;
+    SeaWaveBake& operator=(const SeaWaveBake&) = delete;
+
+    // evaluates the first waveCount waves at time, returns false when the last bake still holds
+    bool bake(float gravity, float time, const glm::vec4* waves, unsigned int waveCount)
+    {
+        waveCount = waveCount > 3 ? 3 : waveCount;
+        if (baked && gravity == lastGravity && time == lastTime && waveCount == lastWaveCount)
+        {
+            bool same = true;
+            for (unsigned int i = 0; i < waveCount; i++)
+                same = same && waves[i] == lastWaves[i];
+            if (same)
+                return false;
+        }
+
+        program.use();
+        program.setVec2("bakeOrigin", bakeOrigin);
+        program.setVec2("bakeExtent", bakeExtent);
+        program.setInt("bakeResolution", (int)size);
+        program.setFloat("gravity", gravity);
+        program.setFloat("time", time);
+        program.setInt("waveCount", (int)waveCount);
+        if (waveCount > 0)
+            program.setVec4Array("waves", waves, waveCount);
+        glBindImageTexture(0, displacementTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+        glBindImageTexture(1, normalTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        program.dispatch((size + groupSize - 1) / groupSize, (size + groupSize - 1) / groupSize);
+        // the sea draw reads the textures through samplers
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        baked = true;
+        lastGravity = gravity;
+        lastTime = time;
+        lastWaveCount = waveCount;
+        for (unsigned int i = 0; i < waveCount; i++)
+            lastWaves[i] = waves[i];
+        bakeCount++;
+        return true;
+    }
+
+    // the uniforms a SEA_BAKED variant needs besides the textures, once per variant
+    void setUniforms(const Shader& shader, int displacementUnit, int normalUnit) const
+    {
+        shader.setInt("displacementMap", displacementUnit);
+        shader.setInt("normalMap", normalUnit);
+        shader.setVec2("bakeOrigin", bakeOrigin);
+        shader.setVec2("bakeExtent", bakeExtent);
+        shader.setFloat("bakeResolution", (float)size);
+    }
+
+    // binds the textures to the units given to setUniforms
+    void bindTextures(int displacementUnit, int normalUnit) const
+    {
+        glActiveTexture(GL_TEXTURE0 + displacementUnit);
+        glBindTexture(GL_TEXTURE_2D, displacementTexture);
+        glActiveTexture(GL_TEXTURE0 + normalUnit);
+        glBindTexture(GL_TEXTURE_2D, normalTexture);
+    }
+
+    unsigned int getResolution() const
+    {
+        return size;
+    }
+
+    // bakes done, skipped ones not counted
+    unsigned int getBakeCount() const
+    {
+        return bakeCount;
+    }
+
+    size_t textureBytes() const
+    {
+        // 16 bytes per displacement texel, 8 per normal
+        return (size_t)size * size * (16 + 8);
+    }
+
+private:
+    static const unsigned int groupSize = 8; // local_size of seaBake.comp
+
+    ComputeShader program;
+    unsigned int size;
+    glm::vec2 bakeOrigin;
+    glm::vec2 bakeExtent;
+    unsigned int displacementTexture;
+    unsigned int normalTexture;
+
+    bool baked;
+    float lastGravity;
+    float lastTime;
+    unsigned int lastWaveCount;
+    glm::vec4 lastWaves[3];
+    unsigned int bakeCount;
+
+    unsigned int createTexture(GLenum format) const
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, format, (GLsizei)size, (GLsizei)size);
+        // linear between texels when the bake is coarser than the mesh, clamped at the edges of the sea
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "../shader/shader.h"
+
+// Leaves out the waves too short to show where they are evaluated, for the sea variants with
+// WAVE_FILTER. A wave spanning fewer than pixelsPerWave pixels at a point's distance, or fewer than
+// samplesPerWave vertices of the mesh around it, would only alias: it is faded out from twice that
+// length and left out below it. The waves are sorted longest first (sortByWavelength), so the shaders
+// stop at the first one left out and distant or sparse vertices loop over fewer waves.
+class SeaWaveFilter
+{
+public:
+    float pixelsPerWave;
+    float samplesPerWave;
+
+    SeaWaveFilter(float pixels = 2.0f, float samples = 2.0f) :
+        pixelsPerWave(pixels),
+        samplesPerWave(samples)
+    {
+    }
+
+    // longest wavelength first, waves of equal length keep their order
+    static void sortByWavelength(glm::vec4* waves, unsigned int count)
+    {
+        for (unsigned int i = 1; i < count; i++)
+        {
+            glm::vec4 wave = waves[i];
+            unsigned int j = i;
+            for (; j > 0 && waves[j - 1].w < wave.w; j--)
+                waves[j] = waves[j - 1];
+            waves[j] = wave;
+        }
+    }
+
+    // projScale is Model::projectionScale; vertexSpacing is the distance between the sea mesh's
+    // vertices, the tessellated sea works out its own
+    void setUniforms(const Shader& shader, float projScale, float vertexSpacing) const
+    {
+        shader.setFloat("pixelCutoff", pixelsPerWave / projScale);
+        shader.setFloat("samplesPerWave", samplesPerWave);
+        shader.setFloat("vertexSpacing", vertexSpacing);
+    }
+};
@@ -0,0 +1,420 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "shaderManager.h"
+#include "programCache.h"
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+// Rebuilds the programs of a ShaderManager when their files change, without stopping the app.
+//
+// A background thread watches the shader directory (inotify on Linux, file modification times
+// elsewhere) and compiles and links the programs that use a changed file on a hidden window whose
+// context shares objects with the main one. update(), called once per frame on the main thread, swaps
+// each successfully linked program into its Shader, after copying the uniform values the old program
+// had, so state set once at startup (samplers) survives. A program that fails to compile or link is
+// reported and dropped, and the old one stays in use. Rebuilt programs are written to the ProgramCache
+// under the same key Shader uses, so the next launch loads the edited program instead of compiling it.
+class ShaderHotReload
+{
+public:
+    ShaderHotReload(ShaderManager& shaderManager, GLFWwindow* mainWindow, const std::string& shaderDirectory) :
+        manager(shaderManager),
+        directory(shaderDirectory),
+        context(NULL),
+        running(true),
+        watchedShaders(0),
+        reloaded(0),
+        failed(0)
+    {
+        // same context hints as the main window, only hidden
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        context = glfwCreateWindow(1, 1, "shader reload", NULL, mainWindow);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (!context)
+        {
+            std::cout << "ERROR::SHADER_HOT_RELOAD::NO_SHARED_CONTEXT" << std::endl;
+            return;
+        }
+        worker = std::thread(&ShaderHotReload::run, this);
+    }
+
+    ~ShaderHotReload()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_one();
+        if (worker.joinable())
+            worker.join();
+        // programs built but never swapped in
+        for (unsigned int i = 0; i < results.size(); i++)
+        {
+            if (results[i].program)
+                glDeleteProgram(results[i].program);
+        }
+        if (context)
+            glfwDestroyWindow(context);
+    }
+
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+    // main thread, once per frame: asks for the programs using changed files and swaps in the finished ones
+    void update()
+    {
+        if (!context)
+            return;
+        if (manager.getShaderCount() != watchedShaders)
+            updateWatched();
+        std::vector<std::string> files;
+        std::vector<Result> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (changed.empty() && results.empty())
+                return;
+            files.assign(changed.begin(), changed.end());
+            changed.clear();
+            done.swap(results);
+        }
+
+        for (unsigned int i = 0; i < done.size(); i++)
+            swapIn(done[i]);
+
+        if (files.empty())
+            return;
+        std::vector<Request> requested;
+        for (unsigned int i = 0; i < manager.getShaderCount(); i++)
+        {
+            Shader& shader = manager.getShader(i);
+            for (unsigned int f = 0; f < files.size(); f++)
+            {
+                if (!shader.isPending() && (shader.getVertexPath() == files[f] || shader.getFragmentPath() == files[f] ||
+                    shader.getControlPath() == files[f] || shader.getEvaluationPath() == files[f]))
+                {
+                    Request request = { &shader, shader.getVertexPath(), shader.getControlPath(), shader.getEvaluationPath(), shader.getFragmentPath(), shader.getDefines() };
+                    requested.push_back(request);
+                    break;
+                }
+            }
+        }
+        if (requested.empty())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.insert(requests.end(), requested.begin(), requested.end());
+        }
+        wake.notify_one();
+    }
+
+    unsigned int getReloaded() const
+    {
+        return reloaded;
+    }
+
+    unsigned int getFailed() const
+    {
+        return failed;
+    }
+
+private:
+    struct Request {
+        Shader* shader;
+        std::string vertexPath;
+        std::string controlPath;    // empty without tessellation
+        std::string evaluationPath;
+        std::string fragmentPath;
+        std::string defines;
+    };
+
+    struct Result {
+        Shader* shader;
+        GLuint program;     // 0 when the build failed
+    };
+
+    ShaderManager& manager;
+    std::string directory;
+    GLFWwindow* context;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running;
+    std::set<std::string> changed;
+    std::vector<Request> requests;
+    std::vector<Result> results;
+    std::vector<std::string> watched;
+    unsigned int watchedShaders;
+    unsigned int reloaded;
+    unsigned int failed;
+
+    // the files of every program, for watchers that look at files rather than the directory
+    void updateWatched()
+    {
+        std::set<std::string> paths;
+        for (unsigned int i = 0; i < manager.getShaderCount(); i++)
+        {
+            Shader& shader = manager.getShader(i);
+            paths.insert(shader.getVertexPath());
+            paths.insert(shader.getFragmentPath());
+            if (shader.hasTessellation())
+            {
+                paths.insert(shader.getControlPath());
+                paths.insert(shader.getEvaluationPath());
+            }
+        }
+        watchedShaders = manager.getShaderCount();
+        std::lock_guard<std::mutex> lock(mutex);
+        watched.assign(paths.begin(), paths.end());
+    }
+
+    void swapIn(const Result& result)
+    {
+        if (!result.program)
+        {
+            failed++;
+            return;
+        }
+        copyUniforms(result.shader->ID, result.program);
+        glDeleteProgram(result.shader->ID);
+        result.shader->ID = result.program;
+        reloaded++;
+        std::cout << "Reloaded " << result.shader->getVertexPath() << " + " << result.shader->getFragmentPath() << std::endl;
+    }
+
+    // background thread: watches the files and builds what update() asks for on the shared context
+    void run()
+    {
+        glfwMakeContextCurrent(context);
+#ifdef __linux__
+        int watch = inotify_init1(IN_NONBLOCK);
+        if (watch < 0 || inotify_add_watch(watch, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+            std::cout << "ERROR::SHADER_HOT_RELOAD::INOTIFY " << directory << " " << errno << std::endl;
+#else
+        std::map<std::string, time_t> modified;
+#endif
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running)
+        {
+            wake.wait_for(lock, std::chrono::milliseconds(200));
+            if (!running)
+                break;
+
+            std::vector<Request> todo;
+            todo.swap(requests);
+            lock.unlock();
+
+            std::vector<std::string> files;
+#ifdef __linux__
+            readEvents(watch, files);
+#else
+            pollFiles(modified, files);
+#endif
+            std::vector<Result> built;
+            for (unsigned int i = 0; i < todo.size(); i++)
+            {
+                Result result = { todo[i].shader, build(todo[i]) };
+                built.push_back(result);
+            }
+            // the main context may only use the programs once they are complete
+            if (!built.empty())
+                glFinish();
+
+            lock.lock();
+            changed.insert(files.begin(), files.end());
+            results.insert(results.end(), built.begin(), built.end());
+        }
+        lock.unlock();
+#ifdef __linux__
+        if (watch >= 0)
+            close(watch);
+#endif
+        glfwMakeContextCurrent(NULL);
+    }
+
+#ifdef __linux__
+    void readEvents(int watch, std::vector<std::string>& files) const
+    {
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t length;
+        while (watch >= 0 && (length = read(watch, buffer, sizeof(buffer))) > 0)
+        {
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+                if (event->len > 0)
+                    files.push_back(directory + "/" + event->name);
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+#else
+    // the watched files, by modification time; the first look only records the times
+    void pollFiles(std::map<std::string, time_t>& modified, std::vector<std::string>& files)
+    {
+        std::vector<std::string> paths;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            paths = watched;
+        }
+        for (unsigned int i = 0; i < paths.size(); i++)
+        {
+            struct stat info;
+            if (stat(paths[i].c_str(), &info) != 0)
+                continue;
+            std::map<std::string, time_t>::iterator it = modified.find(paths[i]);
+            if (it != modified.end() && it->second != info.st_mtime)
+                files.push_back(paths[i]);
+            modified[paths[i]] = info.st_mtime;
+        }
+    }
+#endif
+
+    GLuint build(const Request& request) const
+    {
+        bool tessellated = !request.controlPath.empty();
+        std::string vertexCode, controlCode, evaluationCode, fragmentCode;
+        if (!readFile(request.vertexPath, vertexCode) || !readFile(request.fragmentPath, fragmentCode) ||
+            (tessellated && (!readFile(request.controlPath, controlCode) || !readFile(request.evaluationPath, evaluationCode))))
+        {
+            std::cout << "ERROR::SHADER_HOT_RELOAD::FILE_NOT_SUCCESFULLY_READ " << request.vertexPath << " " << request.fragmentPath << std::endl;
+            return 0;
+        }
+        GLuint vertex = compile(GL_VERTEX_SHADER, Shader::injectDefines(vertexCode, request.defines), request.vertexPath);
+        GLuint fragment = compile(GL_FRAGMENT_SHADER, Shader::injectDefines(fragmentCode, request.defines), request.fragmentPath);
+        GLuint control = 0, evaluation = 0;
+        if (tessellated)
+        {
+            control = compile(GL_TESS_CONTROL_SHADER, Shader::injectDefines(controlCode, request.defines), request.controlPath);
+            evaluation = compile(GL_TESS_EVALUATION_SHADER, Shader::injectDefines(evaluationCode, request.defines), request.evaluationPath);
+        }
+        GLuint program = 0;
+        if (vertex && fragment && (!tessellated || (control && evaluation)))
+        {
+            // the driver strings and binary formats were asked for by the startup shaders on the main
+            // thread, so the cache only reads them here
+            ProgramCache& cache = ProgramCache::instance();
+            ProgramKey key = cache.key(request.vertexPath.c_str(), request.fragmentPath.c_str(), vertexCode + controlCode + evaluationCode, fragmentCode,
+                request.controlPath + request.evaluationPath + request.defines);
+            program = glCreateProgram();
+            glAttachShader(program, vertex);
+            if (tessellated)
+            {
+                glAttachShader(program, control);
+                glAttachShader(program, evaluation);
+            }
+            glAttachShader(program, fragment);
+            cache.prepare(program);
+            glLinkProgram(program);
+            GLint success = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                GLchar infoLog[1024];
+                glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+                std::cout << "ERROR::SHADER_HOT_RELOAD::PROGRAM_LINKING_ERROR " << request.vertexPath << " + " << request.fragmentPath << "\n" << infoLog << std::endl;
+                glDeleteProgram(program);
+                program = 0;
+            }
+            else
+                cache.store(key, program);
+        }
+        glDeleteShader(vertex);
+        glDeleteShader(control);
+        glDeleteShader(evaluation);
+        glDeleteShader(fragment);
+        return program;
+    }
+
+    static GLuint compile(GLenum type, const std::string& code, const std::string& path)
+    {
+        const char* source = code.c_str();
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        GLint success = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+            std::cout << "ERROR::SHADER_HOT_RELOAD::SHADER_COMPILATION_ERROR " << path << "\n" << infoLog << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    static bool readFile(const std::string& path, std::string& text)
+    {
+        std::ifstream file(path.c_str());
+        if (!file)
+            return false;
+        std::stringstream contents;
+        contents << file.rdbuf();
+        text = contents.str();
+        return true;
+    }
+
+    // gives the new program the values the old one had for every uniform they share
+    static void copyUniforms(GLuint from, GLuint to)
+    {
+        GLint count = 0;
+        glGetProgramiv(from, GL_ACTIVE_UNIFORMS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            char name[256];
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(from, (GLuint)i, sizeof(name), NULL, &size, &type, name);
+            GLint source = glGetUniformLocation(from, name);
+            GLint target = glGetUniformLocation(to, name);
+            // uniform block members and arrays past their first element aren't copied
+            if (source < 0 || target < 0)
+                continue;
+            GLfloat f[16];
+            GLint n[4];
+            GLuint u[4];
+            switch (type)
+            {
+            case GL_FLOAT: glGetUniformfv(from, source, f); glProgramUniform1fv(to, target, 1, f); break;
+            case GL_FLOAT_VEC2: glGetUniformfv(from, source, f); glProgramUniform2fv(to, target, 1, f); break;
+            case GL_FLOAT_VEC3: glGetUniformfv(from, source, f); glProgramUniform3fv(to, target, 1, f); break;
+            case GL_FLOAT_VEC4: glGetUniformfv(from, source, f); glProgramUniform4fv(to, target, 1, f); break;
+            case GL_FLOAT_MAT2: glGetUniformfv(from, source, f); glProgramUniformMatrix2fv(to, target, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3: glGetUniformfv(from, source, f); glProgramUniformMatrix3fv(to, target, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4: glGetUniformfv(from, source, f); glProgramUniformMatrix4fv(to, target, 1, GL_FALSE, f); break;
+            case GL_INT:
+            case GL_BOOL:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_3D:
+            case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_ARRAY:
+                glGetUniformiv(from, source, n); glProgramUniform1iv(to, target, 1, n); break;
+            case GL_UNSIGNED_INT: glGetUniformuiv(from, source, u); glProgramUniform1uiv(to, target, 1, u); break;
+            default:
+                break;
+            }
+        }
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "../shader/shader.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <string.h>
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile, which the glad loader doesn't include
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Builds the startup shaders together: add() submits each compile and link straight away and returns
+// the Shader, poll() finishes the ones the driver is done with without waiting for the others, and
+// finish() waits for whatever is left. Loading models and textures between add() and finish() then
+// overlaps with the driver's compiles.
+//
+// With GL_KHR_parallel_shader_compile (or its ARB twin) the driver compiles on its own threads and poll()
+// can ask whether a program is done. Without it there is no way to ask, so poll() leaves everything for
+// finish(); drivers that defer compiles until their results are queried still get the overlap.
+class ShaderManager
+{
+public:
+    typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+    // loader is the GL function loader, glfwGetProcAddress
+    ShaderManager(GLADloadproc loader) :
+        parallel(false),
+        waitedMs(0.0)
+    {
+        const char* names[2] = { "GL_KHR_parallel_shader_compile", "GL_ARB_parallel_shader_compile" };
+        const char* functions[2] = { "glMaxShaderCompilerThreadsKHR", "glMaxShaderCompilerThreadsARB" };
+        for (unsigned int i = 0; i < 2 && !parallel; i++)
+        {
+            MaxShaderCompilerThreadsProc maxThreads = hasExtension(names[i]) ? (MaxShaderCompilerThreadsProc)loader(functions[i]) : NULL;
+            if (maxThreads)
+            {
+                // as many threads as the driver likes
+                maxThreads(0xFFFFFFFFu);
+                parallel = true;
+            }
+        }
+    }
+
+    ShaderManager(const ShaderManager&) = delete;
+    ShaderManager& operator=(const ShaderManager&) = delete;
+
+    // the shader stays owned by the manager, the reference is valid for its lifetime
+    Shader& add(const char* vertexPath, const char* fragmentPath, const std::string& defines = "")
+    {
+        shaders.push_back(std::unique_ptr<Shader>(new Shader(vertexPath, fragmentPath, defines, true)));
+        return *shaders.back();
+    }
+
+    // with tessellation stages
+    Shader& add(const char* vertexPath, const char* controlPath, const char* evaluationPath, const char* fragmentPath, const std::string& defines = "")
+    {
+        shaders.push_back(std::unique_ptr<Shader>(new Shader(vertexPath, controlPath, evaluationPath, fragmentPath, defines, true)));
+        return *shaders.back();
+    }
+
+    // finishes every shader the driver is done with, true once none is pending
+    bool poll()
+    {
+        bool done = true;
+        for (unsigned int i = 0; i < shaders.size(); i++)
+        {
+            Shader& shader = *shaders[i];
+            if (!shader.isPending())
+                continue;
+            GLint complete = GL_FALSE;
+            if (parallel)
+                glGetProgramiv(shader.ID, GL_COMPLETION_STATUS_KHR, &complete);
+            if (complete)
+                shader.finish();
+            else
+                done = false;
+        }
+        return done;
+    }
+
+    // waits for every pending shader
+    void finish()
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < shaders.size(); i++)
+            shaders[i]->finish();
+        waitedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    unsigned int getShaderCount() const
+    {
+        return (unsigned int)shaders.size();
+    }
+
+    Shader& getShader(unsigned int index)
+    {
+        return *shaders[index];
+    }
+
+    bool isParallel() const
+    {
+        return parallel;
+    }
+
+    // time finish() spent waiting for the driver
+    double getWaitedMs() const
+    {
+        return waitedMs;
+    }
+
+private:
+    std::vector<std::unique_ptr<Shader>> shaders;
+    bool parallel;
+    double waitedMs;
+
+    static bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (extension && strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "shaderManager.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdio.h>
+
+// One compile time switch of a shader: its #define name and how many bits its value takes in a
+// permutation key.
+struct PermutationFeature {
+    const char* name;
+    unsigned int bits;
+};
+
+// Variants of one shader specialised by #defines. A variant is named by a key packing the value of
+// every feature, first feature in the lowest bits; it is compiled the first time it's asked for and
+// kept, and its binary goes through the program cache like any other program, so later launches load
+// it. Looking up a variant that exists doesn't allocate, so get() can be called every frame.
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(ShaderManager& shaderManager, const char* vertexShader, const char* fragmentShader, const std::vector<PermutationFeature>& featureList) :
+        manager(shaderManager),
+        vertexPath(vertexShader),
+        controlPath(NULL),
+        evaluationPath(NULL),
+        fragmentPath(fragmentShader),
+        features(featureList)
+    {}
+
+    // variants of a program with tessellation stages
+    ShaderPermutations(ShaderManager& shaderManager, const char* vertexShader, const char* controlShader, const char* evaluationShader, const char* fragmentShader,
+        const std::vector<PermutationFeature>& featureList) :
+        manager(shaderManager),
+        vertexPath(vertexShader),
+        controlPath(controlShader),
+        evaluationPath(evaluationShader),
+        fragmentPath(fragmentShader),
+        features(featureList)
+    {}
+
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    // submits a variant without waiting for it, for the ones likely to be needed soon
+    void prepare(unsigned int key)
+    {
+        if (!find(key))
+            create(key);
+    }
+
+    // the variant, compiled now if it wasn't yet
+    Shader& get(unsigned int key)
+    {
+        Shader* shader = find(key);
+        if (!shader)
+            shader = create(key);
+        shader->finish();
+        return *shader;
+    }
+
+    unsigned int getVariantCount() const
+    {
+        return (unsigned int)variants.size();
+    }
+
+    // the #define lines of a key
+    std::string defines(unsigned int key) const
+    {
+        std::string text;
+        for (unsigned int i = 0; i < features.size(); i++)
+        {
+            char line[128];
+            snprintf(line, sizeof(line), "#define %s %u\n", features[i].name, key & ((1u << features[i].bits) - 1));
+            text += line;
+            key >>= features[i].bits;
+        }
+        return text;
+    }
+
+private:
+    ShaderManager& manager;
+    const char* vertexPath;
+    const char* controlPath;
+    const char* evaluationPath;
+    const char* fragmentPath;
+    std::vector<PermutationFeature> features;
+    std::vector<std::pair<unsigned int, Shader*>> variants;
+
+    Shader* find(unsigned int key) const
+    {
+        for (unsigned int i = 0; i < variants.size(); i++)
+        {
+            if (variants[i].first == key)
+                return variants[i].second;
+        }
+        return NULL;
+    }
+
+    Shader* create(unsigned int key)
+    {
+        Shader* shader = controlPath ? &manager.add(vertexPath, controlPath, evaluationPath, fragmentPath, defines(key)) : &manager.add(vertexPath, fragmentPath, defines(key));
+        variants.push_back(std::make_pair(key, shader));
+        return shader;
+    }
+};
@@ -1,9 +1,8 @@
 #pragma once
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/norm.hpp >
+#include <glm/gtx/norm.hpp>
 
 #include <vector>
 #include <stdio.h>
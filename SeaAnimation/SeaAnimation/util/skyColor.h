@@ -0,0 +1,46 @@
+#ifndef SKY_COLOR_H
+#define SKY_COLOR_H
+
+#include <glm/glm.hpp>
+
+inline glm::vec3 InterpColor(glm::vec3 color1, glm::vec3 color2, float t)
+{
+    return color1 * (1.0f - t) + color2 * t;
+}
+
+// background color for a sun at cenit degrees from the zenith, from midday to midnight
+inline glm::vec3 GetSkyColor(float cenit) {
+    glm::vec3 color1 = glm::vec3(0.701f, 1.0f, 0.996f);
+    glm::vec3 color2 = glm::vec3(0.345f, 0.796f, 0.996f);
+    glm::vec3 color3 = glm::vec3(1.0f, 0.682f, 0.180f);
+    glm::vec3 color4 = glm::vec3(0.929f, 0.349f, 0.007f);
+    glm::vec3 color5 = glm::vec3(0.003f, 0.031f, 0.517f);
+    glm::vec3 color6 = glm::vec3(0.0f);
+
+    glm::vec3 skyColor = glm::vec3(1.0f);
+    float middleDay = 0.0f;
+    float afternoon = 60.0f;
+    float sunsetStart = 70.0f;
+    float sunsetMiddle = 80.0f;
+    float sunsetEnd = 95.0f;
+    float midnight = 180.0f;
+
+    if (cenit < afternoon) {
+        skyColor = InterpColor(color1, color2, cenit / (afternoon - middleDay));
+    }
+    else if (cenit < sunsetStart) {
+        skyColor = InterpColor(color2, color3, (cenit - afternoon) / (sunsetStart - afternoon));
+    }
+    else if (cenit < sunsetMiddle) {
+        skyColor = InterpColor(color3, color4, (cenit - sunsetStart) / (sunsetMiddle - sunsetStart));
+    }
+    else if (cenit < sunsetEnd) {
+        skyColor = InterpColor(color4, color5, (cenit - sunsetMiddle) / (sunsetEnd - sunsetMiddle));
+    }
+    else {
+        skyColor = InterpColor(color5, color6, (cenit - sunsetEnd) / (midnight - sunsetEnd));
+    }
+
+    return skyColor;
+}
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gpuTimer.h"
+#include "primitiveCounter.h"
+#include "seaBenchmarkScene.h"
+#include "seaPatches.h"
+#include "shaderPermutations.h"
+
+#include <iostream>
+#include <iomanip>
+
+// Draws the sea from a few camera positions, once as the pre-tessellated gridSize x gridSize grid and
+// once as patches tessellated on the GPU, and reports the primitives generated and the time per frame
+// of each. gridKey and tessKey are the seaShaders and seaTessShaders keys of the waves without noise
+// layers. Run it with LIBGL_ALWAYS_SOFTWARE=1 to measure Mesa's llvmpipe rather than the GPU.
+inline void runTessBenchmark(ShaderPermutations& gridShaders, ShaderPermutations& tessShaders, unsigned int gridKey, unsigned int tessKey,
+	unsigned int viewportWidth, unsigned int viewportHeight, unsigned int gridSize = 512, unsigned int patches = 32, unsigned int frames = 60)
+{
+	// the waves of the first Menu preset
+	const glm::vec4 waves[3] = { glm::vec4(-0.072f, 1.0f, 0.346f, 20.0f), glm::vec4(0.855f, -0.536f, 0.417f, 12.814f), glm::vec4(0.449f, 0.362f, 0.712f, 19.026f) };
+	const glm::vec3 initPos(-32.0f, -32.0f, 0.0f);
+	const glm::vec3 finalPos(32.0f, 32.0f, 0.0f);
+	const char* viewNames[3] = { "low", "mid", "high" };
+	const glm::vec3 eyes[3] = { glm::vec3(0.0f, -30.0f, 3.0f), glm::vec3(0.0f, -60.0f, 40.0f), glm::vec3(0.0f, -10.0f, 120.0f) };
+	const glm::vec3 targets[3] = { glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f) };
+
+	float fovy = glm::radians(45.0f);
+	glm::mat4 projection = glm::perspective(fovy, (float)viewportWidth / (float)viewportHeight, 0.1f, 1000.0f);
+	float projScale = viewportHeight / (2.0f * glm::tan(0.5f * fovy));
+	std::cout << "Tessellation benchmark on " << glGetString(GL_RENDERER) << ": " << frames << " frames per case, "
+		<< gridSize << "x" << gridSize << " grid vs " << patches << "x" << patches << " patches" << std::endl;
+
+	SeaGrid seaGrid(gridSize, initPos, finalPos, 1.0f);
+	SeaPatches seaPatches(patches, initPos, finalPos, 1.0f);
+
+	glViewport(0, 0, viewportWidth, viewportHeight);
+	glEnable(GL_DEPTH_TEST);
+	Shader* shaders[2] = { &gridShaders.get(gridKey), &tessShaders.get(tessKey) };
+	for (unsigned int v = 0; v < 3; v++)
+	{
+		glm::mat4 view = glm::lookAt(eyes[v], targets[v], glm::vec3(0.0f, 0.0f, 1.0f));
+		std::cout << "  " << std::left << std::setw(5) << viewNames[v] << std::right;
+		for (unsigned int mode = 0; mode < 2; mode++)
+		{
+			Shader& shader = *shaders[mode];
+			shader.use();
+			shader.setMat4("projection", projection);
+			shader.setMat4("view", view);
+			shader.setMat4("model", glm::mat4(1.0f));
+			shader.setVec3("viewPos", eyes[v]);
+			shader.setFloat("gravity", 9.8f);
+			shader.setVec4("waveA", waves[0]);
+			shader.setVec4("waveB", waves[1]);
+			shader.setVec4("waveC", waves[2]);
+			if (mode == 1)
+				seaPatches.setUniforms(shader, waves, 3, projScale);
+
+			GpuTimer gpuTimer;
+			unsigned int seaPass = gpuTimer.addPass("sea");
+			PrimitiveCounter primitives;
+			glFinish();
+			double start = glfwGetTime();
+			for (unsigned int f = 0; f < frames; f++)
+			{
+				gpuTimer.beginFrame();
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				shader.setFloat("time", (float)f / 60.0f);
+				gpuTimer.begin(seaPass);
+				primitives.begin();
+				if (mode == 1)
+				{
+					seaPatches.draw();
+				}
+				else
+				{
+					seaGrid.draw();
+				}
+				primitives.end();
+				gpuTimer.end(seaPass);
+			}
+			glFinish();
+			double elapsed = glfwGetTime() - start;
+			std::cout << std::fixed << std::setprecision(2)
+				<< (mode == 1 ? "  tessellated: " : "  grid: ") << std::setw(8) << primitives.waitLast() << " triangles, "
+				<< elapsed * 1000.0 / frames << " ms/frame, " << gpuTimer.getAverageMs(seaPass) << " ms GPU";
+		}
+		std::cout << std::endl;
+	}
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <iostream>
+#include <stdlib.h>
+#include <limits.h>
+
+// How a texture is sampled and stored, part of the cache key: the same file loaded with different
+// settings is a different GL texture.
+struct TextureSettings {
+    GLint wrap;
+    GLint minFilter;
+    GLint magFilter;
+    bool mipmaps;
+    bool gamma;
+
+    TextureSettings(GLint wrapMode = GL_REPEAT, GLint minFilterMode = GL_LINEAR_MIPMAP_LINEAR, GLint magFilterMode = GL_LINEAR, bool generateMipmaps = true, bool srgb = false) :
+        wrap(wrapMode), minFilter(minFilterMode), magFilter(magFilterMode), mipmaps(generateMipmaps), gamma(srgb)
+    {}
+};
+
+// Process-wide cache of GL textures keyed by canonical path and settings. Textures are reference
+// counted: acquire hands out the cached texture (loading it on a miss) and release gives it back.
+// Unreferenced textures stay resident for reuse until the total goes over the VRAM budget, then
+// the least recently released ones are deleted first.
+class TextureCache
+{
+public:
+    static TextureCache& instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // returns the texture id, 0 if the file couldn't be loaded
+    unsigned int acquire(const std::string& path, const TextureSettings& settings = TextureSettings())
+    {
+        std::string key = makeKey(path, settings);
+        std::unordered_map<std::string, Entry>::iterator it = entries.find(key);
+        if (it != entries.end())
+        {
+            Entry& entry = it->second;
+            if (entry.refCount == 0)
+                unused.erase(entry.unusedPos);
+            entry.refCount++;
+            return entry.id;
+        }
+
+        Entry entry;
+        entry.id = loadTexture(path, settings, entry.bytes);
+        if (entry.id == 0)
+            return 0;
+        entry.refCount = 1;
+        residentBytes += entry.bytes;
+        keys[entry.id] = key;
+        entries[key] = entry;
+        evict();
+        return entry.id;
+    }
+
+    void release(unsigned int id)
+    {
+        std::unordered_map<unsigned int, std::string>::iterator key = keys.find(id);
+        if (key == keys.end())
+            return;
+        Entry& entry = entries[key->second];
+        if (entry.refCount == 0)
+            return;
+        entry.refCount--;
+        if (entry.refCount == 0)
+        {
+            entry.unusedPos = unused.insert(unused.end(), key->second);
+            evict();
+        }
+    }
+
+    // bytes of VRAM the cache may keep; referenced textures are never evicted, so this can be exceeded
+    void setBudget(size_t bytes)
+    {
+        budget = bytes;
+        evict();
+    }
+
+    inline size_t getResidentBytes() const
+    {
+        return residentBytes;
+    }
+
+    inline size_t getTextureCount() const
+    {
+        return entries.size();
+    }
+
+private:
+    struct Entry {
+        unsigned int id;
+        unsigned int refCount;
+        size_t bytes;
+        std::list<std::string>::iterator unusedPos;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<unsigned int, std::string> keys;
+    // unreferenced textures, least recently released first
+    std::list<std::string> unused;
+    size_t residentBytes;
+    size_t budget;
+
+    TextureCache() :
+        residentBytes(0),
+        budget(256 * 1024 * 1024)
+    {}
+
+    void evict()
+    {
+        while (residentBytes > budget && !unused.empty())
+        {
+            std::unordered_map<std::string, Entry>::iterator it = entries.find(unused.front());
+            unused.pop_front();
+            glDeleteTextures(1, &it->second.id);
+            residentBytes -= it->second.bytes;
+            keys.erase(it->second.id);
+            entries.erase(it);
+        }
+    }
+
+    static std::string canonicalPath(const std::string& path)
+    {
+#ifdef _WIN32
+        char resolved[_MAX_PATH];
+        if (_fullpath(resolved, path.c_str(), _MAX_PATH))
+        {
+            std::string canonical = resolved;
+            for (unsigned int i = 0; i < canonical.size(); i++)
+            {
+                if (canonical[i] == '\\')
+                    canonical[i] = '/';
+                else if (canonical[i] >= 'A' && canonical[i] <= 'Z')
+                    canonical[i] = canonical[i] - 'A' + 'a';
+            }
+            return canonical;
+        }
+#else
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved))
+            return resolved;
+#endif
+        return path;
+    }
+
+    static std::string makeKey(const std::string& path, const TextureSettings& settings)
+    {
+        std::string key = canonicalPath(path);
+        key += '|';
+        key += std::to_string(settings.wrap);
+        key += ',';
+        key += std::to_string(settings.minFilter);
+        key += ',';
+        key += std::to_string(settings.magFilter);
+        key += settings.mipmaps ? ",m" : ",-";
+        key += settings.gamma ? ",s" : ",-";
+        return key;
+    }
+
+    static unsigned int loadTexture(const std::string& path, const TextureSettings& settings, size_t& bytes)
+    {
+        bytes = 0;
+        int width, height, nrComponents;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
+        if (!data)
+        {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            return 0;
+        }
+
+        GLenum format = GL_RGBA;
+        GLenum internalFormat = GL_RGBA;
+        if (nrComponents == 1)
+            format = internalFormat = GL_RED;
+        else if (nrComponents == 2)
+            format = internalFormat = GL_RG;
+        else if (nrComponents == 3)
+        {
+            format = GL_RGB;
+            internalFormat = settings.gamma ? GL_SRGB : GL_RGB;
+        }
+        else
+            internalFormat = settings.gamma ? GL_SRGB_ALPHA : GL_RGBA;
+
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (settings.mipmaps)
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, settings.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, settings.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, settings.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, settings.magFilter);
+
+        // GPU side size: components rounded up to 4 bytes for 3-channel formats, a third more for the mip chain
+        size_t texelBytes = nrComponents == 3 ? 4 : (size_t)nrComponents;
+        bytes = (size_t)width * (size_t)height * texelBytes;
+        if (settings.mipmaps)
+            bytes += bytes / 3;
+
+        stbi_image_free(data);
+        return textureID;
+    }
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+
+// Fixed set of worker threads fed from a single queue. Only CPU work goes here, anything touching
+// OpenGL has to stay on the thread that owns the context.
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned int threadCount = 0) :
+		stopping(false)
+	{
+		if (threadCount == 0)
+		{
+			// leave one core for the GL thread, which also takes part in parallelFor
+			unsigned int hw = std::thread::hardware_concurrency();
+			threadCount = hw > 1 ? hw - 1 : 1;
+		}
+		for (unsigned int i = 0; i < threadCount; i++)
+			workers.emplace_back([this]() { workerLoop(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stopping = true;
+		}
+		queueReady.notify_all();
+		for (unsigned int i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// pool shared by the whole application, created on first use
+	static ThreadPool& shared()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	inline unsigned int size() const
+	{
+		return (unsigned int)workers.size();
+	}
+
+	void submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			tasks.push_back(std::move(task));
+		}
+		queueReady.notify_one();
+	}
+
+	// runs fn(i) for every i in [0, count) and returns when all of them are done. The calling thread
+	// works on the range too, so this is safe to call from a worker.
+	template <typename F>
+	void parallelFor(unsigned int count, const F& fn)
+	{
+		if (count == 0)
+			return;
+		if (count == 1 || workers.empty())
+		{
+			for (unsigned int i = 0; i < count; i++)
+				fn(i);
+			return;
+		}
+
+		// heap allocated so helpers that only get scheduled after the range is finished can still
+		// look at it safely; they find no index left and return without touching fn
+		struct Range
+		{
+			std::atomic<unsigned int> next;
+			std::atomic<unsigned int> done;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+		std::shared_ptr<Range> range = std::make_shared<Range>();
+		range->next = 0;
+		range->done = 0;
+
+		const F* body = &fn;
+		auto run = [range, body, count]()
+		{
+			unsigned int finishedHere = 0;
+			for (unsigned int i = range->next++; i < count; i = range->next++)
+			{
+				(*body)(i);
+				finishedHere++;
+			}
+			if (finishedHere > 0 && range->done.fetch_add(finishedHere) + finishedHere == count)
+			{
+				std::lock_guard<std::mutex> lock(range->mutex);
+				range->finished.notify_all();
+			}
+		};
+
+		unsigned int helpers = count - 1 < size() ? count - 1 : size();
+		for (unsigned int i = 0; i < helpers; i++)
+			submit(run);
+		run();
+
+		std::unique_lock<std::mutex> lock(range->mutex);
+		range->finished.wait(lock, [&range, count]() { return range->done.load() == count; });
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex queueMutex;
+	std::condition_variable queueReady;
+	bool stopping;
+
+	void workerLoop()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				queueReady.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (stopping && tasks.empty())
+					return;
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+};
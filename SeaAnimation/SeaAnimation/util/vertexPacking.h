@@ -0,0 +1,107 @@
+#ifndef VERTEX_PACKING_H
+#define VERTEX_PACKING_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+// Storage layouts a Mesh can upload its vertices with.
+enum VertexFormat {
+    VERTEX_FULL,        // Vertex as-is: 56 bytes, everything in floats
+    VERTEX_PACKED,      // PackedVertex: float positions, compressed normal/tangent frame/uvs (28 bytes)
+    VERTEX_QUANTISED    // QuantisedVertex: PackedVertex with positions quantised to the mesh bounds (24 bytes)
+};
+
+// compressed vertex, decoded in shipShader.vs
+struct PackedVertex {
+    // position
+    glm::vec3 Position;
+    // octahedral-encoded normal (snorm16)
+    glm::i16vec2 Normal;
+    // tangent frame quaternion (snorm16), the sign of w holds the bitangent handedness
+    glm::i16vec4 TangentFrame;
+    // half-float texCoords
+    glm::u16vec2 TexCoords;
+};
+
+// same as PackedVertex, but with the position stored as unorm16 relative to the mesh bounds
+struct QuantisedVertex {
+    // quantised position (w is padding)
+    glm::u16vec4 Position;
+    glm::i16vec2 Normal;
+    glm::i16vec4 TangentFrame;
+    glm::u16vec2 TexCoords;
+};
+
+// octahedral mapping of a unit vector into [-1, 1]^2, stored as two snorm16
+inline glm::i16vec2 encodeOctahedral(glm::vec3 n)
+{
+    n /= (glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z));
+    glm::vec2 e = glm::vec2(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        glm::vec2 signs = glm::vec2(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+        e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * signs;
+    }
+    return glm::i16vec2(glm::packSnorm1x16(e.x), glm::packSnorm1x16(e.y));
+}
+
+inline glm::vec3 decodeOctahedral(glm::i16vec2 packed)
+{
+    glm::vec2 e = glm::vec2(glm::unpackSnorm1x16(packed.x), glm::unpackSnorm1x16(packed.y));
+    glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - glm::abs(e.x) - glm::abs(e.y));
+    if (n.z < 0.0f)
+    {
+        glm::vec2 signs = glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+        glm::vec2 xy = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signs;
+        n.x = xy.x;
+        n.y = xy.y;
+    }
+    return glm::normalize(n);
+}
+
+// encodes the (tangent, bitangent, normal) frame as a quaternion. The bitangent is dropped, only its
+// handedness survives as the sign of w, so w is kept away from zero to always have a sign to read.
+inline glm::i16vec4 encodeTangentFrame(glm::vec3 normal, glm::vec3 tangent, glm::vec3 bitangent)
+{
+    glm::vec3 n = glm::normalize(normal);
+    glm::vec3 t = tangent - n * glm::dot(n, tangent);
+    if (glm::dot(t, t) < 1e-12f)
+    {
+        // meshes without uvs have no tangents, any perpendicular vector will do
+        t = glm::abs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    t = glm::normalize(t);
+    glm::vec3 b = glm::cross(n, t);
+    float handedness = glm::dot(b, bitangent) < 0.0f ? -1.0f : 1.0f;
+
+    glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(t, b, n)));
+    if (q.w < 0.0f)
+        q = -q;
+    // smallest w representable as snorm16 that still has a sign
+    const float bias = 1.0f / 32767.0f;
+    if (q.w < bias)
+    {
+        float s = glm::sqrt(1.0f - bias * bias);
+        q = glm::quat(bias, q.x * s, q.y * s, q.z * s);
+    }
+    if (handedness < 0.0f)
+        q = -q;
+    return glm::i16vec4(glm::packSnorm1x16(q.x), glm::packSnorm1x16(q.y), glm::packSnorm1x16(q.z), glm::packSnorm1x16(q.w));
+}
+
+inline glm::u16vec2 encodeHalfTexCoords(glm::vec2 uv)
+{
+    return glm::u16vec2(glm::packHalf1x16(uv.x), glm::packHalf1x16(uv.y));
+}
+
+// maps a position inside [boundsMin, boundsMin + boundsExtent] to unorm16
+inline glm::u16vec4 quantisePosition(glm::vec3 p, glm::vec3 boundsMin, glm::vec3 boundsExtent)
+{
+    glm::vec3 extent = glm::max(boundsExtent, glm::vec3(1e-20f));
+    glm::vec3 t = glm::clamp((p - boundsMin) / extent, 0.0f, 1.0f);
+    return glm::u16vec4(glm::packUnorm1x16(t.x), glm::packUnorm1x16(t.y), glm::packUnorm1x16(t.z), 0);
+}
+
+#endif
@@ -0,0 +1,229 @@
+#include "microBench.h"
+
+#include "util/shipMovement.h"
+#include "util/camera3d.h"
+#include "util/seaMesh.h"
+#include "util/skyColor.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+using namespace std;
+
+// Micro-benchmarks of the CPU side math of the scene: wave evaluation, ship orientation, camera matrix,
+// sky color and the sea grid. Nothing here needs a window or a GL context, it builds on its own with
+// the Makefile next to it.
+//
+// usage: SeaBench [--filter name] [--time ms per sample] [--evict-mb size] [--csv]
+
+// deterministic inputs, the same on every run
+static float random01(unsigned int& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (float)(state >> 8) / 16777216.0f;
+}
+
+static glm::vec3 randomUnit(unsigned int& state)
+{
+    glm::vec3 v(random01(state) * 2.0f - 1.0f, random01(state) * 2.0f - 1.0f, random01(state) * 2.0f - 1.0f);
+    return glm::length2(v) > 1e-6f ? glm::normalize(v) : glm::vec3(0.0f, 0.0f, 1.0f);
+}
+
+// the scene's default waves
+static const glm::vec4 waves[3] = {
+    glm::vec4(-0.072f, 1.0f, 0.346f, 20.0f),
+    glm::vec4(0.855f, -0.536f, 0.417f, 12.814f),
+    glm::vec4(0.449f, 0.362f, 0.712f, 19.026f)
+};
+
+static void benchGerstnerWave(MicroBench& bench)
+{
+    // points on the sea grid: one is the ship, 512 x 512 the whole sea mesh
+    unsigned int sizes[] = { 1, 64, 4096, 512 * 512 };
+    ShipMovement ship;
+    for (unsigned int s = 0; s < 4; s++)
+    {
+        unsigned int count = sizes[s];
+        unsigned int side = (unsigned int)glm::sqrt((float)count);
+        vector<glm::vec3> points(count);
+        for (unsigned int i = 0; i < count; i++)
+            points[i] = glm::vec3(-32.0f + 64.0f * (float)(i % side) / side, -32.0f + 64.0f * (float)(i / side) / side, 0.0f);
+        vector<glm::vec3> displaced(count);
+        float time = 0.0f;
+        for (int cold = 0; cold < 2; cold++)
+        {
+            bench.run("ShipMovement::GerstnerWave", "points=" + to_string(count) + " waves=3", (unsigned long long)count * 3, cold == 1, [&]()
+            {
+                glm::vec3 tangent(0.0f), binormal(0.0f);
+                time += 1.0f / 60.0f;
+                for (unsigned int i = 0; i < count; i++)
+                {
+                    glm::vec3 p = points[i];
+                    for (unsigned int w = 0; w < 3; w++)
+                        p += ship.GerstnerWave(waves[w], points[i], tangent, binormal, 9.8f, time);
+                    displaced[i] = p;
+                }
+                consume(displaced[count / 2].z + tangent.x + binormal.y);
+            });
+        }
+    }
+}
+
+static void benchRotationBetweenVectors(MicroBench& bench)
+{
+    // ship tangents as main.cpp passes them, arbitrary directions, and the opposite direction fallback
+    const char* cases[] = { "ship tangent", "random", "opposite" };
+    ShipMovement ship;
+    const unsigned int count = 4096;
+    for (unsigned int c = 0; c < 3; c++)
+    {
+        unsigned int state = 7;
+        vector<glm::vec3> from(count), to(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec3 v = randomUnit(state);
+            if (c == 0)
+            {
+                glm::vec3 tangent(1.0f, v.y * 0.2f, v.z * 0.3f);
+                from[i] = glm::vec3(tangent.x, tangent.y, 0.0f);
+                to[i] = glm::vec3(tangent.x, tangent.y, tangent.z / 4.0f);
+            }
+            else
+            {
+                from[i] = v;
+                to[i] = c == 1 ? randomUnit(state) : -v;
+            }
+        }
+        for (int cold = 0; cold < 2; cold++)
+        {
+            bench.run("ShipMovement::RotationBetweenVectors", cases[c], count, cold == 1, [&]()
+            {
+                float sum = 0.0f;
+                for (unsigned int i = 0; i < count; i++)
+                    sum += ship.RotationBetweenVectors(from[i], to[i]).w;
+                consume(sum);
+            });
+        }
+    }
+}
+
+static void benchCameraViewMatrix(MicroBench& bench)
+{
+    // one camera is the app, more cameras show the cost once they no longer stay in cache
+    unsigned int sizes[] = { 1, 4096 };
+    for (unsigned int s = 0; s < 2; s++)
+    {
+        unsigned int count = sizes[s];
+        unsigned int state = 11;
+        vector<Camera3D> cameras(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            cameras[i].Phi = random01(state) * 360.0f;
+            cameras[i].Theta = 1.0f + random01(state) * 178.0f;
+            cameras[i].Radius = 1.0f + random01(state) * 99.0f;
+        }
+        for (int cold = 0; cold < 2; cold++)
+        {
+            bench.run("Camera3D::GetViewMatrix", "cameras=" + to_string(count), count, cold == 1, [&]()
+            {
+                float sum = 0.0f;
+                for (unsigned int i = 0; i < count; i++)
+                    sum += cameras[i].GetViewMatrix()[3][2];
+                consume(sum);
+            });
+        }
+    }
+}
+
+static void benchSkyColor(MicroBench& bench)
+{
+    // daytime stays in the first branch, a full day in random order makes the branches unpredictable
+    const char* cases[] = { "day", "sunset", "full day sorted", "full day random" };
+    const unsigned int count = 4096;
+    for (unsigned int c = 0; c < 4; c++)
+    {
+        unsigned int state = 3;
+        vector<float> cenit(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (c == 0)
+                cenit[i] = random01(state) * 60.0f;
+            else if (c == 1)
+                cenit[i] = 60.0f + random01(state) * 35.0f;
+            else if (c == 2)
+                cenit[i] = 180.0f * (float)i / count;
+            else
+                cenit[i] = random01(state) * 180.0f;
+        }
+        for (int cold = 0; cold < 2; cold++)
+        {
+            bench.run("GetSkyColor", cases[c], count, cold == 1, [&]()
+            {
+                glm::vec3 sum(0.0f);
+                for (unsigned int i = 0; i < count; i++)
+                    sum += GetSkyColor(cenit[i]);
+                consume(sum.x + sum.y + sum.z);
+            });
+        }
+    }
+}
+
+static void benchSeaMesh(MicroBench& bench)
+{
+    // per vertex, the allocation and release of the arrays included; 512 is the size main.cpp builds
+    unsigned int sizes[] = { 64, 128, 256, 512 };
+    for (unsigned int s = 0; s < 4; s++)
+    {
+        unsigned int n = sizes[s];
+        for (int cold = 0; cold < 2; cold++)
+        {
+            bench.run("createSeaMesh (per vertex)", "N=" + to_string(n), (unsigned long long)n * n, cold == 1, [&]()
+            {
+                float* vertices;
+                unsigned int* indices;
+                createSeaMesh(vertices, indices, n, glm::vec3(-32.0f, -32.0f, 0.0f), glm::vec3(32.0f, 32.0f, 0.0f), 1.0f);
+                consume(vertices[(n * n / 2) * 5] + (float)indices[3]);
+                delete[] vertices;
+                delete[] indices;
+            });
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    string filter;
+    double sampleMs = 20.0;
+    unsigned int evictMb = 64;
+    bool csv = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--time" && i + 1 < argc)
+            sampleMs = atof(argv[++i]);
+        else if (arg == "--evict-mb" && i + 1 < argc)
+            evictMb = (unsigned int)atoi(argv[++i]);
+        else if (arg == "--csv")
+            csv = true;
+        else
+        {
+            cout << "usage: SeaBench [--filter name] [--time ms per sample] [--evict-mb size] [--csv]" << endl;
+            return 2;
+        }
+    }
+
+    MicroBench bench(filter, sampleMs > 0.0 ? sampleMs : 20.0, evictMb > 0 ? evictMb : 64, csv);
+    benchGerstnerWave(bench);
+    benchRotationBetweenVectors(bench);
+    benchCameraViewMatrix(bench);
+    benchSkyColor(bench);
+    benchSeaMesh(bench);
+    return 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+// Results are summed into this so the compiler can't drop the work being timed.
+static volatile float benchSink = 0.0f;
+
+inline void consume(float value)
+{
+	benchSink = benchSink + value;
+}
+
+// Times benchmark passes and prints ns per operation. A pass does `ops` operations; a warm run repeats
+// passes back to back with the data and code already cached, a cold run evicts the caches before every
+// pass by streaming through a buffer larger than the last level cache, and only times the pass itself.
+// Each run takes `samples` measurements and reports their median and fastest.
+class MicroBench
+{
+public:
+	MicroBench(const std::string& nameFilter = "", double sampleMs = 20.0, unsigned int evictMb = 64, bool csvOutput = false) :
+		filter(nameFilter),
+		targetMs(sampleMs),
+		samples(9),
+		csv(csvOutput),
+		evictBuffer((size_t)evictMb * 1024 * 1024, 1),
+		headerPrinted(false)
+	{}
+
+	// evicting takes milliseconds, so a cold sample stops at this many passes even if short of the target time
+	static const unsigned int maxColdPasses = 32;
+
+	bool enabled(const std::string& name) const
+	{
+		return filter.empty() || name.find(filter) != std::string::npos;
+	}
+
+	template <typename Pass>
+	void run(const std::string& name, const std::string& params, unsigned long long ops, bool cold, Pass pass)
+	{
+		if (!enabled(name) || ops == 0)
+			return;
+
+		// passes per sample, enough to reach the target time; a cold pass is timed on its own
+		pass();
+		unsigned long long passes = 1;
+		if (!cold)
+		{
+			while (passes < (1ull << 30) && elapsedMs(pass, passes) < targetMs)
+				passes *= 2;
+		}
+
+		std::vector<double> nsPerOp;
+		for (unsigned int s = 0; s < samples; s++)
+		{
+			double ms = 0.0;
+			if (cold)
+			{
+				unsigned long long count = 0;
+				do
+				{
+					evictCaches();
+					ms += elapsedMs(pass, 1);
+					count++;
+				} while (ms < targetMs && count < maxColdPasses);
+				passes = count;
+			}
+			else
+			{
+				ms = elapsedMs(pass, passes);
+			}
+			nsPerOp.push_back(ms * 1e6 / ((double)passes * (double)ops));
+		}
+		std::sort(nsPerOp.begin(), nsPerOp.end());
+		print(name, params, cold, nsPerOp[nsPerOp.size() / 2], nsPerOp[0], ops);
+	}
+
+private:
+	std::string filter;
+	double targetMs;
+	unsigned int samples;
+	bool csv;
+	std::vector<char> evictBuffer;
+	bool headerPrinted;
+
+	template <typename Pass>
+	static double elapsedMs(Pass& pass, unsigned long long passes)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned long long i = 0; i < passes; i++)
+			pass();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void evictCaches()
+	{
+		// one write per cache line is enough to pull every line of the buffer through the caches
+		char value = (char)(evictBuffer[0] + 1);
+		for (size_t i = 0; i < evictBuffer.size(); i += 64)
+			evictBuffer[i] = value;
+		consume((float)evictBuffer[evictBuffer.size() / 2]);
+	}
+
+	void print(const std::string& name, const std::string& params, bool cold, double medianNs, double minNs, unsigned long long ops)
+	{
+		if (!headerPrinted)
+		{
+			if (csv)
+				std::cout << "benchmark,params,cache,ns_per_op,min_ns_per_op,ops_per_pass" << std::endl;
+			else
+				std::cout << std::left << std::setw(38) << "benchmark" << std::setw(22) << "params" << std::setw(7) << "cache"
+					<< std::right << std::setw(12) << "ns/op" << std::setw(12) << "min ns/op" << std::setw(12) << "ops/pass" << std::endl;
+			headerPrinted = true;
+		}
+		const char* cache = cold ? "cold" : "warm";
+		if (csv)
+		{
+			std::cout << name << "," << params << "," << cache << "," << medianNs << "," << minNs << "," << ops << std::endl;
+			return;
+		}
+		std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(38) << name << std::setw(22) << params << std::setw(7) << cache
+			<< std::right << std::setw(12) << medianNs << std::setw(12) << minNs << std::setw(12) << ops << std::endl;
+	}
+};